@@ -264,6 +264,8 @@ typedef struct SingleChannelElement {
     DECLARE_ALIGNED(32, INTFLOAT, saved)[1536];     ///< overlap
     DECLARE_ALIGNED(32, INTFLOAT, ret_buf)[2048];   ///< PCM output buffer
     DECLARE_ALIGNED(16, INTFLOAT, ltp_state)[3072]; ///< time signal for LTP
+    DECLARE_ALIGNED(32, INTFLOAT, buf_mdct)[1024];  ///< IMDCT output, temporary
+    DECLARE_ALIGNED(32, INTFLOAT, temp)[128];       ///< windowing buffer, temporary
     DECLARE_ALIGNED(32, AAC_FLOAT, lcoeffs)[1024];  ///< MDCT of LTP coefficients (used by encoder)
     DECLARE_ALIGNED(32, AAC_FLOAT, prcoeffs)[1024]; ///< Main prediction coefs (used by encoder)
     PredictorState predictor_state[MAX_PREDICTORS];
@@ -309,14 +311,6 @@ struct AACContext {
     int warned_remapping_once;
     /** @} */
 
-    /**
-     * @name temporary aligned temporary buffers
-     * (We do not want to have these on the stack.)
-     * @{
-     */
-    DECLARE_ALIGNED(32, INTFLOAT, buf_mdct)[1024];
-    /** @} */
-
     /**
      * @name Computed / set up during initialization
      * @{
@@ -352,7 +346,14 @@ struct AACContext {
     int dmono_mode;      ///< 0->not dmono, 1->use first channel, 2->use second channel
     /** @} */
 
-    DECLARE_ALIGNED(32, INTFLOAT, temp)[128];
+    /**
+     * @name Channel elements run through spectral_to_sample() by slice threads
+     * @{
+     */
+    uint8_t thread_elems[4 * MAX_ELEM_ID][2]; ///< type and id of each element
+    int nb_thread_elems;
+    int thread_samples;
+    /** @} */
 
     OutputConfiguration oc[2];
     int warned_num_aac_frames;
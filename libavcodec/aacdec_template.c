@@ -2677,7 +2677,7 @@ static void apply_ltp(AACContext *ac, SingleChannelElement *sce)
 
     if (sce->ics.window_sequence[0] != EIGHT_SHORT_SEQUENCE) {
         INTFLOAT *predTime = sce->ret;
-        INTFLOAT *predFreq = ac->buf_mdct;
+        INTFLOAT *predFreq = sce->buf_mdct;
         int16_t num_samples = 2048;
 
         if (ltp->lag < 1024)
@@ -2713,22 +2713,22 @@ static void update_ltp(AACContext *ac, SingleChannelElement *sce)
     if (ics->window_sequence[0] == EIGHT_SHORT_SEQUENCE) {
         memcpy(saved_ltp,       saved, 512 * sizeof(*saved_ltp));
         memset(saved_ltp + 576, 0,     448 * sizeof(*saved_ltp));
-        ac->fdsp->vector_fmul_reverse(saved_ltp + 448, ac->buf_mdct + 960,     &swindow[64],      64);
+        ac->fdsp->vector_fmul_reverse(saved_ltp + 448, sce->buf_mdct + 960,     &swindow[64],      64);
 
         for (i = 0; i < 64; i++)
-            saved_ltp[i + 512] = AAC_MUL31(ac->buf_mdct[1023 - i], swindow[63 - i]);
+            saved_ltp[i + 512] = AAC_MUL31(sce->buf_mdct[1023 - i], swindow[63 - i]);
     } else if (ics->window_sequence[0] == LONG_START_SEQUENCE) {
-        memcpy(saved_ltp,       ac->buf_mdct + 512, 448 * sizeof(*saved_ltp));
+        memcpy(saved_ltp,       sce->buf_mdct + 512, 448 * sizeof(*saved_ltp));
         memset(saved_ltp + 576, 0,                  448 * sizeof(*saved_ltp));
-        ac->fdsp->vector_fmul_reverse(saved_ltp + 448, ac->buf_mdct + 960,     &swindow[64],      64);
+        ac->fdsp->vector_fmul_reverse(saved_ltp + 448, sce->buf_mdct + 960,     &swindow[64],      64);
 
         for (i = 0; i < 64; i++)
-            saved_ltp[i + 512] = AAC_MUL31(ac->buf_mdct[1023 - i], swindow[63 - i]);
+            saved_ltp[i + 512] = AAC_MUL31(sce->buf_mdct[1023 - i], swindow[63 - i]);
     } else { // LONG_STOP or ONLY_LONG
-        ac->fdsp->vector_fmul_reverse(saved_ltp,       ac->buf_mdct + 512,     &lwindow[512],     512);
+        ac->fdsp->vector_fmul_reverse(saved_ltp,       sce->buf_mdct + 512,     &lwindow[512],     512);
 
         for (i = 0; i < 512; i++)
-            saved_ltp[i + 512] = AAC_MUL31(ac->buf_mdct[1023 - i], lwindow[511 - i]);
+            saved_ltp[i + 512] = AAC_MUL31(sce->buf_mdct[1023 - i], lwindow[511 - i]);
     }
 
     memcpy(sce->ltp_state,      sce->ltp_state+1024, 1024 * sizeof(*sce->ltp_state));
@@ -2748,8 +2748,8 @@ static void imdct_and_windowing(AACContext *ac, SingleChannelElement *sce)
     const INTFLOAT *swindow      = ics->use_kb_window[0] ? AAC_RENAME2(aac_kbd_short_128) : AAC_RENAME2(sine_128);
     const INTFLOAT *lwindow_prev = ics->use_kb_window[1] ? AAC_RENAME2(aac_kbd_long_1024) : AAC_RENAME2(sine_1024);
     const INTFLOAT *swindow_prev = ics->use_kb_window[1] ? AAC_RENAME2(aac_kbd_short_128) : AAC_RENAME2(sine_128);
-    INTFLOAT *buf  = ac->buf_mdct;
-    INTFLOAT *temp = ac->temp;
+    INTFLOAT *buf  = sce->buf_mdct;
+    INTFLOAT *temp = sce->temp;
     int i;
 
     // imdct
@@ -2817,8 +2817,8 @@ static void imdct_and_windowing_960(AACContext *ac, SingleChannelElement *sce)
     const INTFLOAT *swindow      = ics->use_kb_window[0] ? AAC_RENAME(aac_kbd_short_120) : AAC_RENAME(sine_120);
     const INTFLOAT *lwindow_prev = ics->use_kb_window[1] ? AAC_RENAME(aac_kbd_long_960) : AAC_RENAME(sine_960);
     const INTFLOAT *swindow_prev = ics->use_kb_window[1] ? AAC_RENAME(aac_kbd_short_120) : AAC_RENAME(sine_120);
-    INTFLOAT *buf  = ac->buf_mdct;
-    INTFLOAT *temp = ac->temp;
+    INTFLOAT *buf  = sce->buf_mdct;
+    INTFLOAT *temp = sce->temp;
     int i;
 
     // imdct
@@ -2876,7 +2876,7 @@ static void imdct_and_windowing_ld(AACContext *ac, SingleChannelElement *sce)
     INTFLOAT *in    = sce->coeffs;
     INTFLOAT *out   = sce->ret;
     INTFLOAT *saved = sce->saved;
-    INTFLOAT *buf  = ac->buf_mdct;
+    INTFLOAT *buf  = sce->buf_mdct;
 #if USE_FIXED
     int i;
 #endif /* USE_FIXED */
@@ -2908,7 +2908,7 @@ static void imdct_and_windowing_eld(AACContext *ac, SingleChannelElement *sce)
     UINTFLOAT *in   = sce->coeffs;
     INTFLOAT *out   = sce->ret;
     INTFLOAT *saved = sce->saved;
-    INTFLOAT *buf  = ac->buf_mdct;
+    INTFLOAT *buf  = sce->buf_mdct;
     int i;
     const int n  = ac->oc[1].m4ac.frame_length_short ? 480 : 512;
     const int n2 = n >> 1;
@@ -3009,9 +3009,79 @@ static void apply_channel_coupling(AACContext *ac, ChannelElement *cc,
 /**
  * Convert spectral data to samples, applying all supported tools as appropriate.
  */
+static void spectral_to_sample_element(AACContext *ac, ChannelElement *che,
+                                       int type, int i, int samples,
+                                       void (*imdct_and_window)(AACContext *ac, SingleChannelElement *sce))
+{
+    if (type <= TYPE_CPE)
+        apply_channel_coupling(ac, che, type, i, BEFORE_TNS, AAC_RENAME(apply_dependent_coupling));
+    if (ac->oc[1].m4ac.object_type == AOT_AAC_LTP) {
+        if (che->ch[0].ics.predictor_present) {
+            if (che->ch[0].ics.ltp.present)
+                ac->apply_ltp(ac, &che->ch[0]);
+            if (che->ch[1].ics.ltp.present && type == TYPE_CPE)
+                ac->apply_ltp(ac, &che->ch[1]);
+        }
+    }
+    if (che->ch[0].tns.present)
+        ac->apply_tns(che->ch[0].coeffs, &che->ch[0].tns, &che->ch[0].ics, 1);
+    if (che->ch[1].tns.present)
+        ac->apply_tns(che->ch[1].coeffs, &che->ch[1].tns, &che->ch[1].ics, 1);
+    if (type <= TYPE_CPE)
+        apply_channel_coupling(ac, che, type, i, BETWEEN_TNS_AND_IMDCT, AAC_RENAME(apply_dependent_coupling));
+    if (type != TYPE_CCE || che->coup.coupling_point == AFTER_IMDCT) {
+        imdct_and_window(ac, &che->ch[0]);
+        if (ac->oc[1].m4ac.object_type == AOT_AAC_LTP)
+            ac->update_ltp(ac, &che->ch[0]);
+        if (type == TYPE_CPE) {
+            imdct_and_window(ac, &che->ch[1]);
+            if (ac->oc[1].m4ac.object_type == AOT_AAC_LTP)
+                ac->update_ltp(ac, &che->ch[1]);
+        }
+        if (ac->oc[1].m4ac.sbr > 0) {
+            AAC_RENAME(ff_sbr_apply)(ac, &che->sbr, type, che->ch[0].ret, che->ch[1].ret);
+        }
+    }
+    if (type <= TYPE_CCE)
+        apply_channel_coupling(ac, che, type, i, AFTER_IMDCT, AAC_RENAME(apply_independent_coupling));
+
+#if USE_FIXED
+    {
+        int j;
+        /* preparation for resampler */
+        for(j = 0; j<samples; j++){
+            che->ch[0].ret[j] = (int32_t)av_clip64((int64_t)che->ch[0].ret[j]*128, INT32_MIN, INT32_MAX-0x8000)+0x8000;
+            if(type == TYPE_CPE)
+                che->ch[1].ret[j] = (int32_t)av_clip64((int64_t)che->ch[1].ret[j]*128, INT32_MIN, INT32_MAX-0x8000)+0x8000;
+        }
+    }
+#endif /* USE_FIXED */
+    che->present = 0;
+}
+
+/**
+ * Minimum number of channels in the elements handed to slice threads.
+ * Dispatching the jobs costs about as much as decoding one channel, so
+ * mono, stereo and other small layouts are decoded serially.
+ */
+#define MIN_THREAD_CHANNELS 6
+
+static int spectral_to_sample_thread(AVCodecContext *avctx, void *arg,
+                                     int jobnr, int threadnr)
+{
+    AACContext *ac = arg;
+    int type = ac->thread_elems[jobnr][0];
+    int i    = ac->thread_elems[jobnr][1];
+
+    spectral_to_sample_element(ac, ac->che[type][i], type, i,
+                               ac->thread_samples, ac->imdct_and_windowing);
+    return 0;
+}
+
 static void spectral_to_sample(AACContext *ac, int samples)
 {
     int i, type;
+    int threaded = 0, nb_channels = 0;
     void (*imdct_and_window)(AACContext *ac, SingleChannelElement *sce);
     switch (ac->oc[1].m4ac.object_type) {
     case AOT_ER_AAC_LD:
@@ -3023,62 +3093,44 @@ static void spectral_to_sample(AACContext *ac, int samples)
     default:
         if (ac->oc[1].m4ac.frame_length_short)
             imdct_and_window = imdct_and_windowing_960;
-        else
+        else {
             imdct_and_window = ac->imdct_and_windowing;
+            /* The 960 and low delay transforms use shared scratch buffers,
+             * everything else only touches the element being processed. */
+            threaded = ac->avctx->active_thread_type & FF_THREAD_SLICE;
+        }
     }
+
+    /* Coupling channel elements are processed first because the other
+     * elements mix them in; those do not depend on each other and are
+     * handed to slice threads when there are enough of them. */
+    ac->nb_thread_elems = 0;
     for (type = 3; type >= 0; type--) {
         for (i = 0; i < MAX_ELEM_ID; i++) {
             ChannelElement *che = ac->che[type][i];
             if (che && che->present) {
-                if (type <= TYPE_CPE)
-                    apply_channel_coupling(ac, che, type, i, BEFORE_TNS, AAC_RENAME(apply_dependent_coupling));
-                if (ac->oc[1].m4ac.object_type == AOT_AAC_LTP) {
-                    if (che->ch[0].ics.predictor_present) {
-                        if (che->ch[0].ics.ltp.present)
-                            ac->apply_ltp(ac, &che->ch[0]);
-                        if (che->ch[1].ics.ltp.present && type == TYPE_CPE)
-                            ac->apply_ltp(ac, &che->ch[1]);
-                    }
+                if (threaded && type != TYPE_CCE) {
+                    ac->thread_elems[ac->nb_thread_elems][0] = type;
+                    ac->thread_elems[ac->nb_thread_elems][1] = i;
+                    ac->nb_thread_elems++;
+                    nb_channels += 1 + (type == TYPE_CPE);
+                    continue;
                 }
-                if (che->ch[0].tns.present)
-                    ac->apply_tns(che->ch[0].coeffs, &che->ch[0].tns, &che->ch[0].ics, 1);
-                if (che->ch[1].tns.present)
-                    ac->apply_tns(che->ch[1].coeffs, &che->ch[1].tns, &che->ch[1].ics, 1);
-                if (type <= TYPE_CPE)
-                    apply_channel_coupling(ac, che, type, i, BETWEEN_TNS_AND_IMDCT, AAC_RENAME(apply_dependent_coupling));
-                if (type != TYPE_CCE || che->coup.coupling_point == AFTER_IMDCT) {
-                    imdct_and_window(ac, &che->ch[0]);
-                    if (ac->oc[1].m4ac.object_type == AOT_AAC_LTP)
-                        ac->update_ltp(ac, &che->ch[0]);
-                    if (type == TYPE_CPE) {
-                        imdct_and_window(ac, &che->ch[1]);
-                        if (ac->oc[1].m4ac.object_type == AOT_AAC_LTP)
-                            ac->update_ltp(ac, &che->ch[1]);
-                    }
-                    if (ac->oc[1].m4ac.sbr > 0) {
-                        AAC_RENAME(ff_sbr_apply)(ac, &che->sbr, type, che->ch[0].ret, che->ch[1].ret);
-                    }
-                }
-                if (type <= TYPE_CCE)
-                    apply_channel_coupling(ac, che, type, i, AFTER_IMDCT, AAC_RENAME(apply_independent_coupling));
-
-#if USE_FIXED
-                {
-                    int j;
-                    /* preparation for resampler */
-                    for(j = 0; j<samples; j++){
-                        che->ch[0].ret[j] = (int32_t)av_clip64((int64_t)che->ch[0].ret[j]*128, INT32_MIN, INT32_MAX-0x8000)+0x8000;
-                        if(type == TYPE_CPE)
-                            che->ch[1].ret[j] = (int32_t)av_clip64((int64_t)che->ch[1].ret[j]*128, INT32_MIN, INT32_MAX-0x8000)+0x8000;
-                    }
-                }
-#endif /* USE_FIXED */
-                che->present = 0;
+                spectral_to_sample_element(ac, che, type, i, samples, imdct_and_window);
             } else if (che) {
                 av_log(ac->avctx, AV_LOG_VERBOSE, "ChannelElement %d.%d missing \n", type, i);
             }
         }
     }
+
+    ac->thread_samples = samples;
+    if (nb_channels >= MIN_THREAD_CHANNELS) {
+        ac->avctx->execute2(ac->avctx, spectral_to_sample_thread, ac, NULL,
+                            ac->nb_thread_elems);
+    } else {
+        for (i = 0; i < ac->nb_thread_elems; i++)
+            spectral_to_sample_thread(ac->avctx, ac, i, 0);
+    }
 }
 
 static int parse_adts_frame_header(AACContext *ac, GetBitContext *gb)
@@ -2382,6 +2382,20 @@ typedef struct AVCodecContext {
      * - decoding: unused
      */
     int (*get_encode_buffer)(struct AVCodecContext *s, AVPacket *pkt, int flags);
+
+    /**
+     * Skip sample reconstruction for selected frames.
+     *
+     * The bitstream is still parsed completely and frame side data such as
+     * motion vectors or video encoding parameters is exported as requested
+     * through export_side_data, but motion compensation, intra prediction,
+     * IDCT and loop filtering are not performed. The content of the decoded
+     * pictures is undefined.
+     *
+     * - encoding: unused
+     * - decoding: Set by user.
+     */
+    enum AVDiscard skip_recon;
 } AVCodecContext;
 
 #if FF_API_CODEC_GET_SET
@@ -784,6 +784,385 @@ static av_always_inline void hl_decode_mb_idct_luma(const H264Context *h, H264Sl
     }
 }
 
+/* Reduced resolution reconstruction (AVCodecContext.lowres):
+ * every output sample is the full resolution sample at the bottom-right
+ * corner of the area it covers, which keeps the last row and column of each
+ * block for the intra prediction of its neighbours. Intra prediction is
+ * approximated from the already reconstructed low resolution neighbours,
+ * motion compensation interpolates bilinearly in the low resolution
+ * references and only the DC coefficient of each transform block is added.
+ * Loop filtering is disabled. */
+enum {
+    LOWRES_PRED_DC,
+    LOWRES_PRED_LEFT_DC,
+    LOWRES_PRED_TOP_DC,
+    LOWRES_PRED_DC_128,
+    LOWRES_PRED_VERT,
+    LOWRES_PRED_HOR,
+    LOWRES_PRED_DIAG,
+    LOWRES_PRED_PLANE,
+};
+
+static const uint8_t lowres_pred4x4[DC_128_PRED + 1] = {
+    [VERT_PRED]            = LOWRES_PRED_VERT,
+    [HOR_PRED]             = LOWRES_PRED_HOR,
+    [DC_PRED]              = LOWRES_PRED_DC,
+    [DIAG_DOWN_LEFT_PRED]  = LOWRES_PRED_VERT,
+    [DIAG_DOWN_RIGHT_PRED] = LOWRES_PRED_DIAG,
+    [VERT_RIGHT_PRED]      = LOWRES_PRED_DIAG,
+    [HOR_DOWN_PRED]        = LOWRES_PRED_DIAG,
+    [VERT_LEFT_PRED]       = LOWRES_PRED_VERT,
+    [HOR_UP_PRED]          = LOWRES_PRED_HOR,
+    [LEFT_DC_PRED]         = LOWRES_PRED_LEFT_DC,
+    [TOP_DC_PRED]          = LOWRES_PRED_TOP_DC,
+    [DC_128_PRED]          = LOWRES_PRED_DC_128,
+};
+
+static const uint8_t lowres_pred8x8[ALZHEIMER_DC_0L0_PRED8x8 + 1] = {
+    [DC_PRED8x8]      = LOWRES_PRED_DC,
+    [HOR_PRED8x8]     = LOWRES_PRED_HOR,
+    [VERT_PRED8x8]    = LOWRES_PRED_VERT,
+    [PLANE_PRED8x8]   = LOWRES_PRED_PLANE,
+    [LEFT_DC_PRED8x8] = LOWRES_PRED_LEFT_DC,
+    [TOP_DC_PRED8x8]  = LOWRES_PRED_TOP_DC,
+    [DC_128_PRED8x8]  = LOWRES_PRED_DC_128,
+};
+
+/* index of the 4x4 block covering each 4x4 area of a macroblock, raster order */
+static const uint8_t lowres_block_index[16] = {
+     0,  1,  4,  5,
+     2,  3,  6,  7,
+     8,  9, 12, 13,
+    10, 11, 14, 15,
+};
+
+/**
+ * @return full resolution position of the low resolution sample i
+ */
+static av_always_inline int lowres_pos(int i, int lowres)
+{
+    return (i << lowres) | ((1 << lowres) - 1);
+}
+
+static void lowres_pred(uint8_t *dst, ptrdiff_t stride, int w, int h,
+                        int lowres, int mode, int has_top, int has_left)
+{
+    const uint8_t *top = dst - stride;
+    int x, y, dc = 0;
+
+    if (mode != LOWRES_PRED_DC_128) {
+        if (!has_top && !has_left)
+            mode = LOWRES_PRED_DC_128;
+        else if (!has_top && mode != LOWRES_PRED_HOR)
+            mode = LOWRES_PRED_LEFT_DC;
+        else if (!has_left && mode != LOWRES_PRED_VERT)
+            mode = LOWRES_PRED_TOP_DC;
+    }
+
+    switch (mode) {
+    case LOWRES_PRED_VERT:
+        for (y = 0; y < h; y++)
+            memcpy(dst + y * stride, top, w);
+        return;
+    case LOWRES_PRED_HOR:
+        for (y = 0; y < h; y++)
+            memset(dst + y * stride, dst[y * stride - 1], w);
+        return;
+    case LOWRES_PRED_DIAG:
+        for (y = 0; y < h; y++)
+            for (x = 0; x < w; x++)
+                dst[y * stride + x] = x > y ? top[x - y - 1] :
+                                      x < y ? dst[(y - x - 1) * stride - 1] :
+                                              top[-1];
+        return;
+    case LOWRES_PRED_PLANE: {
+        /* H.264 plane prediction with the full resolution neighbours
+         * replaced by the nearest low resolution ones */
+        const int n = w << lowres;
+        int b = 0, c = 0, a;
+        for (x = 1; x <= n / 2; x++) {
+            const int k = n / 2 - 1 - x;
+            b += x * (top[n / 2 - 1 + x >> lowres] - (k < 0 ? top[-1] : top[k >> lowres]));
+            c += x * (dst[(n / 2 - 1 + x >> lowres) * stride - 1] -
+                      (k < 0 ? top[-1] : dst[(k >> lowres) * stride - 1]));
+        }
+        if (n == 16) {
+            b = 5 * b + 32 >> 6;
+            c = 5 * c + 32 >> 6;
+        } else {
+            b = 17 * b + 16 >> 5;
+            c = 17 * c + 16 >> 5;
+        }
+        a = 16 * (top[w - 1] + dst[(h - 1) * stride - 1]) + 16;
+        for (y = 0; y < h; y++)
+            for (x = 0; x < w; x++)
+                dst[y * stride + x] = av_clip_uint8(a + b * (lowres_pos(x, lowres) - n / 2 + 1) +
+                                                        c * (lowres_pos(y, lowres) - n / 2 + 1) >> 5);
+        return;
+    }
+    case LOWRES_PRED_DC:
+        for (x = 0; x < w; x++)
+            dc += top[x];
+        for (y = 0; y < h; y++)
+            dc += dst[y * stride - 1];
+        dc = (dc + (w + h >> 1)) / (w + h);
+        break;
+    case LOWRES_PRED_LEFT_DC:
+        for (y = 0; y < h; y++)
+            dc += dst[y * stride - 1];
+        dc = (dc + (h >> 1)) / h;
+        break;
+    case LOWRES_PRED_TOP_DC:
+        for (x = 0; x < w; x++)
+            dc += top[x];
+        dc = (dc + (w >> 1)) / w;
+        break;
+    default:
+        dc = 128;
+        break;
+    }
+
+    for (y = 0; y < h; y++)
+        memset(dst + y * stride, dc, w);
+}
+
+static void lowres_add_dc(uint8_t *dst, ptrdiff_t stride, int w, int h, int dc)
+{
+    int x, y;
+
+    dc = (dc + 32) >> 6;
+    if (!dc)
+        return;
+    for (y = 0; y < h; y++)
+        for (x = 0; x < w; x++)
+            dst[y * stride + x] = av_clip_uint8(dst[y * stride + x] + dc);
+}
+
+/**
+ * DC coefficient of the 4x4 transform block n; at lowres 3 a sample covers
+ * the 2x2 blocks of n, their DCs are averaged.
+ */
+static av_always_inline int lowres_block_dc(const int16_t *mb, int n, int lowres)
+{
+    if (lowres < 3)
+        return mb[16 * n];
+    n &= ~3;
+    return mb[16 * n] + mb[16 * n + 16] + mb[16 * n + 32] + mb[16 * n + 48] + 2 >> 2;
+}
+
+/**
+ * Predict the bw x bh low resolution samples of plane p at (x, y), which
+ * are covered by block n, from a reference of the given list. All of them
+ * share the motion vector and so the bilinear weights. The prediction is
+ * averaged with dst if avg is set.
+ */
+static void lowres_mc_block(const H264Context *h, H264SliceContext *sl,
+                            int list, int n, int p, uint8_t *dst, ptrdiff_t stride,
+                            int x, int y, int bw, int bh, int avg)
+{
+    const int lowres  = h->avctx->lowres;
+    const int shift   = lowres + (p ? 3 : 2);
+    const int mask    = (1 << shift) - 1;
+    const int width   = 16 * h->mb_width  >> !!p >> lowres;
+    const int height  = 16 * h->mb_height >> !!p >> lowres;
+    const H264Ref *ref = &sl->ref_list[list][sl->ref_cache[list][scan8[n]]];
+    const ptrdiff_t src_stride = ref->linesize[p];
+    const uint8_t *src = ref->data[p];
+    const int mx = (x << shift) + sl->mv_cache[list][scan8[n]][0];
+    const int my = (y << shift) + sl->mv_cache[list][scan8[n]][1];
+    const int wx1 = mx & mask, wx0 = mask + 1 - wx1;
+    const int wy1 = my & mask, wy0 = mask + 1 - wy1;
+    int i, j;
+
+    if (HAVE_THREADS && (h->avctx->active_thread_type & FF_THREAD_FRAME)) {
+        const int last = av_clip((my >> shift) + bh, 0, height - 1);
+        ff_thread_await_progress(&ref->parent->tf,
+                                 FFMIN((lowres_pos(last, lowres) << !!p) + !!p,
+                                       16 * h->mb_height - 1), 0);
+    }
+
+    for (j = 0; j < bh; j++) {
+        const uint8_t *src0 = src + av_clip((my >> shift) + j,     0, height - 1) * src_stride;
+        const uint8_t *src1 = src + av_clip((my >> shift) + j + 1, 0, height - 1) * src_stride;
+
+        for (i = 0; i < bw; i++) {
+            const int x0 = av_clip((mx >> shift) + i,     0, width - 1);
+            const int x1 = av_clip((mx >> shift) + i + 1, 0, width - 1);
+            int val = ((src0[x0] * wx0 + src0[x1] * wx1) * wy0 +
+                       (src1[x0] * wx0 + src1[x1] * wx1) * wy1 +
+                       (1 << (2 * shift - 1))) >> (2 * shift);
+
+            if (avg)
+                val = dst[j * stride + i] + val + 1 >> 1;
+            dst[j * stride + i] = val;
+        }
+    }
+}
+
+/**
+ * Motion compensate the w x h luma partition at (x, y) of the current
+ * macroblock, starting at block n, and the chroma it covers, from the
+ * lists it uses.
+ */
+static void lowres_mc_part(const H264Context *h, H264SliceContext *sl,
+                           uint8_t *dest[3], int n, int x, int y, int w, int hgt,
+                           int list0, int list1)
+{
+    const int lowres = h->avctx->lowres;
+    int p;
+
+    for (p = 0; p < 3; p++) {
+        const int s  = !!p;
+        const int x0 = x >> s >> lowres, x1 = x + w >> s >> lowres;
+        const int y0 = y >> s >> lowres, y1 = y + hgt >> s >> lowres;
+        const int mbsize = 16 >> s >> lowres;
+        const ptrdiff_t stride = p ? sl->uvlinesize : sl->linesize;
+        const int gx = sl->mb_x * mbsize + x0;
+        const int gy = sl->mb_y * mbsize + y0;
+        uint8_t *ptr = dest[p] + y0 * stride + x0;
+        int avg = 0, j;
+
+        if (x0 == x1 || y0 == y1)
+            continue;
+        if (list0 && sl->ref_cache[0][scan8[n]] >= 0) {
+            lowres_mc_block(h, sl, 0, n, p, ptr, stride, gx, gy, x1 - x0, y1 - y0, 0);
+            avg = 1;
+        }
+        if (list1 && sl->ref_cache[1][scan8[n]] >= 0) {
+            lowres_mc_block(h, sl, 1, n, p, ptr, stride, gx, gy, x1 - x0, y1 - y0, avg);
+            avg = 1;
+        }
+        if (!avg)
+            for (j = 0; j < y1 - y0; j++)
+                memset(ptr + j * stride, 128, x1 - x0);
+    }
+}
+
+static void hl_decode_mb_lowres(const H264Context *h, H264SliceContext *sl)
+{
+    const int lowres   = h->avctx->lowres;
+    const int mb_x     = sl->mb_x;
+    const int mb_y     = sl->mb_y;
+    const int mb_xy    = sl->mb_xy;
+    const int mb_type  = h->cur_pic.mb_type[mb_xy];
+    const int size     = 16 >> lowres;
+    const int uvsize   = 8 >> lowres;
+    const ptrdiff_t linesize   = sl->linesize;
+    const ptrdiff_t uvlinesize = sl->uvlinesize;
+    int16_t *mb = sl->mb;
+    uint8_t *dest[3];
+    int x, y, i, p;
+
+    dest[0] = h->cur_pic.f->data[0] + (mb_x + mb_y * linesize) * size;
+    dest[1] = h->cur_pic.f->data[1] + (mb_x + mb_y * uvlinesize) * uvsize;
+    dest[2] = h->cur_pic.f->data[2] + (mb_x + mb_y * uvlinesize) * uvsize;
+
+    h->list_counts[mb_xy] = sl->list_count;
+
+    if (IS_INTRA_PCM(mb_type)) {
+        const uint8_t *src = sl->intra_pcm_ptr;
+        for (y = 0; y < size; y++)
+            for (x = 0; x < size; x++)
+                dest[0][y * linesize + x] = src[lowres_pos(y, lowres) * 16 + lowres_pos(x, lowres)];
+        for (p = 1; p < 3; p++) {
+            src = sl->intra_pcm_ptr + 256 + 64 * (p - 1);
+            for (y = 0; y < uvsize; y++)
+                for (x = 0; x < uvsize; x++)
+                    dest[p][y * uvlinesize + x] = src[lowres_pos(y, lowres) * 8 + lowres_pos(x, lowres)];
+        }
+        return;
+    }
+
+    if (IS_INTRA(mb_type)) {
+        for (p = 1; p < 3; p++)
+            lowres_pred(dest[p], uvlinesize, uvsize, uvsize, lowres,
+                        lowres_pred8x8[sl->chroma_pred_mode], mb_y, mb_x);
+
+        if (IS_INTRA4x4(mb_type)) {
+            const int step = IS_8x8DCT(mb_type) ? 4 : 1;
+            const int bs   = IS_8x8DCT(mb_type) ? 8 : 4;
+            for (i = 0; i < 16; i += step) {
+                const int bx = 4 * ((scan8[i] - scan8[0]) & 7);
+                const int by = 4 * ((scan8[i] - scan8[0]) >> 3);
+                const int x0 = bx >> lowres, x1 = bx + bs >> lowres;
+                const int y0 = by >> lowres, y1 = by + bs >> lowres;
+                uint8_t *ptr = dest[0] + y0 * linesize + x0;
+
+                if (x0 == x1 || y0 == y1)
+                    continue;
+                lowres_pred(ptr, linesize, x1 - x0, y1 - y0, lowres,
+                            lowres_pred4x4[sl->intra4x4_pred_mode_cache[scan8[i]]],
+                            mb_y || y0, mb_x || x0);
+                lowres_add_dc(ptr, linesize, x1 - x0, y1 - y0,
+                              bs == 8 ? mb[16 * i] : lowres_block_dc(mb, i, lowres));
+            }
+        } else {
+            lowres_pred(dest[0], linesize, size, size, lowres,
+                        lowres_pred8x8[sl->intra16x16_pred_mode], mb_y, mb_x);
+            if (sl->non_zero_count_cache[scan8[LUMA_DC_BLOCK_INDEX]])
+                h->h264dsp.h264_luma_dc_dequant_idct(mb, sl->mb_luma_dc[0],
+                                                     h->ps.pps->dequant4_coeff[0][sl->qscale][0]);
+        }
+    } else {
+        const int list0 = USES_LIST(mb_type, 0);
+        const int list1 = USES_LIST(mb_type, 1);
+
+        /* partitions share their motion, split 8x8 blocks are
+         * predicted per 4x4 block */
+        if (IS_16X16(mb_type)) {
+            lowres_mc_part(h, sl, dest, 0, 0, 0, 16, 16, list0, list1);
+        } else if (IS_16X8(mb_type)) {
+            lowres_mc_part(h, sl, dest, 0, 0, 0, 16, 8, list0, list1);
+            lowres_mc_part(h, sl, dest, 8, 0, 8, 16, 8, list0, list1);
+        } else if (IS_8X16(mb_type)) {
+            lowres_mc_part(h, sl, dest, 0, 0, 0, 8, 16, list0, list1);
+            lowres_mc_part(h, sl, dest, 4, 8, 0, 8, 16, list0, list1);
+        } else {
+            for (i = 0; i < 4; i++) {
+                const int x8 = (i & 1) << 3, y8 = (i & 2) << 2;
+
+                if (IS_SUB_8X8(sl->sub_mb_type[i])) {
+                    lowres_mc_part(h, sl, dest, 4 * i, x8, y8, 8, 8, list0, list1);
+                } else {
+                    int j;
+                    for (j = 0; j < 4; j++)
+                        lowres_mc_part(h, sl, dest, 4 * i + j,
+                                       x8 + ((j & 1) << 2), y8 + ((j & 2) << 1), 4, 4, list0, list1);
+                }
+            }
+        }
+    }
+
+    if (!IS_INTRA4x4(mb_type) && (IS_INTRA16x16(mb_type) || (sl->cbp & 15))) {
+        for (y = 0; y < size; y++) {
+            for (x = 0; x < size; x++) {
+                const int fx = lowres_pos(x, lowres), fy = lowres_pos(y, lowres);
+                const int n  = lowres_block_index[(fy >> 2) * 4 + (fx >> 2)];
+                lowres_add_dc(dest[0] + y * linesize + x, linesize, 1, 1,
+                              IS_8x8DCT(mb_type) ? mb[16 * (n & ~3)] : lowres_block_dc(mb, n, lowres));
+            }
+        }
+    }
+
+    if (sl->cbp & 0x30) {
+        for (p = 1; p < 3; p++) {
+            if (sl->non_zero_count_cache[scan8[CHROMA_DC_BLOCK_INDEX + p - 1]])
+                h->h264dsp.h264_chroma_dc_dequant_idct(mb + 256 * p,
+                                                       h->ps.pps->dequant4_coeff[IS_INTRA(mb_type) ? p : p + 3][sl->chroma_qp[p - 1]][0]);
+            for (y = 0; y < uvsize; y++) {
+                for (x = 0; x < uvsize; x++) {
+                    const int n = 16 * p + (lowres_pos(y, lowres) >> 2) * 2 + (lowres_pos(x, lowres) >> 2);
+                    lowres_add_dc(dest[p] + y * uvlinesize + x, uvlinesize, 1, 1,
+                                  lowres_block_dc(mb, n, lowres));
+                }
+            }
+        }
+    }
+
+    if (sl->cbp || IS_INTRA16x16(mb_type))
+        memset(mb, 0, 16 * 48 * sizeof(*mb));
+}
+
 #define BITS   8
 #define SIMPLE 1
 #include "h264_mb_template.c"
@@ -803,6 +1182,19 @@ void ff_h264_hl_decode_mb(const H264Context *h, H264SliceContext *sl)
     int is_complex    = CONFIG_SMALL || sl->is_complex ||
                         IS_INTRA_PCM(mb_type) || sl->qscale == 0;
 
+    if (sl->skip_recon) {
+        /* the residual is normally cleared by the IDCT, the parser relies
+         * on all coefficients being zero at the start of the next MB */
+        if (sl->cbp)
+            memset(sl->mb, 0, (16 * 48 * sizeof(*sl->mb)) << h->pixel_shift);
+        return;
+    }
+
+    if (h->avctx->lowres) {
+        hl_decode_mb_lowres(h, sl);
+        return;
+    }
+
     if (CHROMA444(h)) {
         if (is_complex || h->pixel_shift)
             hl_decode_mb_444_complex(h, sl);
@@ -883,6 +883,10 @@ static enum AVPixelFormat get_pixel_format(H264Context *h, int force_callback)
 
     *fmt = AV_PIX_FMT_NONE;
 
+    /* hwaccels only reconstruct at full resolution */
+    if (h->avctx->lowres && choices == pix_fmts)
+        choices = fmt - 1;
+
     for (i=0; choices[i] != AV_PIX_FMT_NONE; i++)
         if (choices[i] == h->avctx->pix_fmt && !force_callback)
             return choices[i];
@@ -920,6 +924,16 @@ static void init_dimensions(H264Context *h)
         h->height_from_caller = 0;
     }
 
+    if (h->avctx->lowres) {
+        const int lowres = h->avctx->lowres;
+        cl   >>= lowres;
+        ct   >>= lowres;
+        width  = AV_CEIL_RSHIFT(width,  lowres);
+        height = AV_CEIL_RSHIFT(height, lowres);
+        cr     = AV_CEIL_RSHIFT(h->width,  lowres) - width  - cl;
+        cb     = AV_CEIL_RSHIFT(h->height, lowres) - height - ct;
+    }
+
     h->avctx->coded_width  = h->width;
     h->avctx->coded_height = h->height;
     h->avctx->width        = width;
@@ -974,6 +988,17 @@ static int h264_slice_header_init(H264Context *h)
         goto fail;
     }
 
+    if (h->avctx->lowres &&
+        (sps->bit_depth_luma != 8 || sps->bit_depth_chroma != 8 ||
+         sps->chroma_format_idc != 1 || !sps->frame_mbs_only_flag ||
+         sps->transform_bypass)) {
+        avpriv_report_missing_feature(h->avctx,
+                                      "lowres decoding of interlaced, lossless "
+                                      "or non 8-bit 4:2:0 streams");
+        ret = AVERROR_PATCHWELCOME;
+        goto fail;
+    }
+
     h->cur_bit_depth_luma         =
     h->avctx->bits_per_raw_sample = sps->bit_depth_luma;
     h->cur_chroma_format_idc      = sps->chroma_format_idc;
@@ -1966,6 +1991,16 @@ static int h264_slice_header_parse(const H264Context *h, H264SliceContext *sl,
     return 0;
 }
 
+static int discard_slice(const H264Context *h, const H264SliceContext *sl,
+                         const H2645NAL *nal, enum AVDiscard skip)
+{
+    return skip >= AVDISCARD_ALL ||
+           (skip >= AVDISCARD_NONKEY   && h->nal_unit_type != H264_NAL_IDR_SLICE) ||
+           (skip >= AVDISCARD_NONINTRA && sl->slice_type_nos != AV_PICTURE_TYPE_I) ||
+           (skip >= AVDISCARD_BIDIR    && sl->slice_type_nos == AV_PICTURE_TYPE_B) ||
+           (skip >= AVDISCARD_NONREF   && nal->ref_idc == 0);
+}
+
 /* do all the per-slice initialization needed before we can start decoding the
  * actual MBs */
 static int h264_slice_init(H264Context *h, H264SliceContext *sl,
@@ -2009,15 +2044,9 @@ static int h264_slice_init(H264Context *h, H264SliceContext *sl,
     if (!h->setup_finished)
         ff_h264_direct_ref_list_init(h, sl);
 
-    if (h->avctx->skip_loop_filter >= AVDISCARD_ALL ||
-        (h->avctx->skip_loop_filter >= AVDISCARD_NONKEY &&
-         h->nal_unit_type != H264_NAL_IDR_SLICE) ||
-        (h->avctx->skip_loop_filter >= AVDISCARD_NONINTRA &&
-         sl->slice_type_nos != AV_PICTURE_TYPE_I) ||
-        (h->avctx->skip_loop_filter >= AVDISCARD_BIDIR  &&
-         sl->slice_type_nos == AV_PICTURE_TYPE_B) ||
-        (h->avctx->skip_loop_filter >= AVDISCARD_NONREF &&
-         nal->ref_idc == 0))
+    sl->skip_recon = discard_slice(h, sl, nal, h->avctx->skip_recon);
+    if (sl->skip_recon || h->avctx->lowres ||
+        discard_slice(h, sl, nal, h->avctx->skip_loop_filter))
         sl->deblocking_filter = 0;
 
     if (sl->deblocking_filter == 1 && h->nb_slice_ctx > 1) {
@@ -113,7 +113,9 @@ void ff_h264_draw_horiz_band(const H264Context *h, H264SliceContext *sl,
         y      <<= 1;
     }
 
-    height = FFMIN(height, avctx->height - y);
+    y      >>= avctx->lowres;
+    height   = AV_CEIL_RSHIFT(height, avctx->lowres);
+    height   = FFMIN(height, avctx->height - y);
 
     if (field_pic && h->first_field && !(avctx->slice_flags & SLICE_FLAG_ALLOW_FIELD))
         return;
@@ -411,6 +413,10 @@ static av_cold int h264_decode_init(AVCodecContext *avctx)
     if (h->enable_er < 0 && (avctx->active_thread_type & FF_THREAD_SLICE))
         h->enable_er = 0;
 
+    /* error concealment works on full resolution pictures */
+    if (avctx->lowres)
+        h->enable_er = 0;
+
     if (h->enable_er && (avctx->active_thread_type & FF_THREAD_SLICE)) {
         av_log(avctx, AV_LOG_WARNING,
                "Error resilience with slice threads is enabled. It is unsafe and unsupported and may crash. "
@@ -1087,5 +1093,6 @@ AVCodec ff_h264_decoder = {
     .flush                 = h264_decode_flush,
     .update_thread_context = ONLY_IF_THREADS_ENABLED(ff_h264_update_thread_context),
     .profiles              = NULL_IF_CONFIG_SMALL(ff_h264_profiles),
+    .max_lowres            = 3,
     .priv_class            = &h264_class,
 };
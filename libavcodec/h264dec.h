@@ -294,6 +294,10 @@ typedef struct H264SliceContext {
     int edge_emu_buffer_allocated;
     int top_borders_allocated[2];
 
+    /* Set when the MBs of this slice are only parsed, see
+     * AVCodecContext.skip_recon. */
+    int skip_recon;
+
     /**
      * non zero coeff count cache.
      * is 64 if not available.
@@ -843,7 +843,8 @@ void ff_hevc_hls_filter(HEVCContext *s, int x, int y, int ctb_size)
 {
     int x_end = x >= s->ps.sps->width  - ctb_size;
     int skip = 0;
-    if (s->avctx->skip_loop_filter >= AVDISCARD_ALL ||
+    if (s->skip_recon ||
+        s->avctx->skip_loop_filter >= AVDISCARD_ALL ||
         (s->avctx->skip_loop_filter >= AVDISCARD_NONKEY && !IS_IDR(s)) ||
         (s->avctx->skip_loop_filter >= AVDISCARD_NONINTRA &&
          s->sh.slice_type != HEVC_SLICE_I) ||
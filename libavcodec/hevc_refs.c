@@ -38,6 +38,7 @@ void ff_hevc_unref_frame(HEVCContext *s, HEVCFrame *frame, int flags)
     frame->flags &= ~flags;
     if (!frame->flags) {
         ff_thread_release_buffer(s->avctx, &frame->tf);
+        ff_thread_release_buffer(s->avctx, &frame->tf_lowres);
 
         av_buffer_unref(&frame->tab_mvf_buf);
         frame->tab_mvf = NULL;
@@ -87,11 +88,24 @@ static HEVCFrame *alloc_frame(HEVCContext *s)
         if (frame->frame->buf[0])
             continue;
 
+        /* with lowres, pictures are decoded at full resolution and
+         * downscaled into frame_lowres for output */
+        if (s->avctx->lowres) {
+            frame->frame->width  = s->ps.sps->width;
+            frame->frame->height = s->ps.sps->height;
+        }
+
         ret = ff_thread_get_buffer(s->avctx, &frame->tf,
                                    AV_GET_BUFFER_FLAG_REF);
         if (ret < 0)
             return NULL;
 
+        if (s->avctx->lowres) {
+            ret = ff_thread_get_buffer(s->avctx, &frame->tf_lowres, 0);
+            if (ret < 0)
+                goto fail;
+        }
+
         frame->rpl_buf = av_buffer_allocz(s->pkt.nb_nals * sizeof(RefPicListTab));
         if (!frame->rpl_buf)
             goto fail;
@@ -208,7 +222,7 @@ int ff_hevc_output_frame(HEVCContext *s, AVFrame *out, int flush)
         if (nb_output) {
             HEVCFrame *frame = &s->DPB[min_idx];
 
-            ret = av_frame_ref(out, frame->frame);
+            ret = av_frame_ref(out, s->avctx->lowres ? frame->frame_lowres : frame->frame);
             if (frame->flags & HEVC_FRAME_FLAG_BUMPING)
                 ff_hevc_unref_frame(s, frame, HEVC_FRAME_FLAG_OUTPUT | HEVC_FRAME_FLAG_BUMPING);
             else
@@ -325,8 +325,10 @@ static void export_stream_params(HEVCContext *s, const HEVCSPS *sps)
     avctx->pix_fmt             = sps->pix_fmt;
     avctx->coded_width         = sps->width;
     avctx->coded_height        = sps->height;
-    avctx->width               = sps->width  - ow->left_offset - ow->right_offset;
-    avctx->height              = sps->height - ow->top_offset  - ow->bottom_offset;
+    avctx->width               = AV_CEIL_RSHIFT((int)(sps->width  - ow->left_offset - ow->right_offset),
+                                                avctx->lowres);
+    avctx->height              = AV_CEIL_RSHIFT((int)(sps->height - ow->top_offset  - ow->bottom_offset),
+                                                avctx->lowres);
     avctx->has_b_frames        = sps->temporal_layer[sps->max_sub_layers - 1].num_reorder_pics;
     avctx->profile             = sps->ptl.general_ptl.profile_idc;
     avctx->level               = sps->ptl.general_ptl.level_idc;
@@ -474,6 +476,9 @@ static enum AVPixelFormat get_format(HEVCContext *s, const HEVCSPS *sps)
         break;
     }
 
+    /* the low resolution pictures are downscaled from the software ones */
+    if (s->avctx->lowres)
+        fmt = pix_fmts;
     *fmt++ = sps->pix_fmt;
     *fmt = AV_PIX_FMT_NONE;
 
@@ -1449,6 +1454,9 @@ static int hls_pcm_sample(HEVCContext *s, int x0, int y0, int log2_cb_size)
     if (!s->sh.disable_deblocking_filter_flag)
         ff_hevc_deblocking_boundary_strengths(s, x0, y0, log2_cb_size);
 
+    if (s->skip_recon)
+        return 0;
+
     ret = init_get_bits(&gb, pcm, length);
     if (ret < 0)
         return ret;
@@ -1897,6 +1905,9 @@ static void hls_prediction_unit(HEVCContext *s, int x0, int y0,
         for (i = 0; i < nPbW >> s->ps.sps->log2_min_pu_size; i++)
             tab_mvf[(y_pu + j) * min_pu_width + x_pu + i] = current_mv;
 
+    if (s->skip_recon)
+        return;
+
     if (current_mv.pred_flag & PF_L0) {
         ref0 = refPicList[0].ref[current_mv.ref_idx[0]];
         if (!ref0)
@@ -2901,6 +2912,35 @@ static int set_side_data(HEVCContext *s)
     return 0;
 }
 
+static void intra_pred_skip(HEVCContext *s, int x0, int y0, int c_idx)
+{
+}
+
+/**
+ * Export the properties of the current picture on its low resolution output
+ * frame, with the cropping scaled down.
+ */
+static int set_lowres_props(HEVCContext *s)
+{
+    const int lowres = s->avctx->lowres;
+    const AVFrame *src = s->ref->frame;
+    AVFrame *dst       = s->ref->frame_lowres;
+    const int width    = src->width  - src->crop_left - src->crop_right;
+    const int height   = src->height - src->crop_top  - src->crop_bottom;
+    int ret;
+
+    ret = av_frame_copy_props(dst, src);
+    if (ret < 0)
+        return ret;
+
+    dst->crop_left   = src->crop_left >> lowres;
+    dst->crop_top    = src->crop_top  >> lowres;
+    dst->crop_right  = dst->width  - AV_CEIL_RSHIFT(width,  lowres) - dst->crop_left;
+    dst->crop_bottom = dst->height - AV_CEIL_RSHIFT(height, lowres) - dst->crop_top;
+
+    return 0;
+}
+
 static int hevc_frame_start(HEVCContext *s)
 {
     HEVCLocalContext *lc = s->HEVClc;
@@ -2919,6 +2959,22 @@ static int hevc_frame_start(HEVCContext *s)
 
     s->no_rasl_output_flag = IS_IDR(s) || IS_BLA(s) || (s->nal_unit_type == HEVC_NAL_CRA_NUT && s->last_eos);
 
+    s->skip_recon = s->avctx->skip_recon >= AVDISCARD_ALL ||
+                    (s->avctx->skip_recon >= AVDISCARD_NONKEY && !IS_IDR(s)) ||
+                    (s->avctx->skip_recon >= AVDISCARD_NONINTRA &&
+                     s->sh.slice_type != HEVC_SLICE_I) ||
+                    (s->avctx->skip_recon >= AVDISCARD_BIDIR &&
+                     s->sh.slice_type == HEVC_SLICE_B) ||
+                    (s->avctx->skip_recon >= AVDISCARD_NONREF &&
+                     ff_hevc_nal_is_nonref(s->nal_unit_type));
+    if (s->skip_recon) {
+        int i;
+        for (i = 0; i < FF_ARRAY_ELEMS(s->hpc.intra_pred); i++)
+            s->hpc.intra_pred[i] = intra_pred_skip;
+    } else if (s->hpc.intra_pred[0] == intra_pred_skip) {
+        ff_hevc_pred_init(&s->hpc, s->ps.sps->bit_depth);
+    }
+
     if (s->ps.pps->tiles_enabled_flag)
         lc->end_of_tiles_x = s->ps.pps->column_width[0] << s->ps.sps->log2_ctb_size;
 
@@ -2940,6 +2996,12 @@ static int hevc_frame_start(HEVCContext *s)
 
     s->frame->pict_type = 3 - s->sh.slice_type;
 
+    if (s->avctx->lowres) {
+        ret = set_lowres_props(s);
+        if (ret < 0)
+            goto fail;
+    }
+
     if (!IS_IRAP(s))
         ff_hevc_bump_frame(s);
 
@@ -3147,6 +3209,86 @@ fail:
     return 0;
 }
 
+/**
+ * @return rounded average of the w x h samples at src
+ */
+static av_always_inline int downscale_block(const uint8_t *src, ptrdiff_t stride,
+                                            int w, int h, int pixel_shift)
+{
+    int sum = 0, i, j;
+
+    for (j = 0; j < h; j++) {
+        for (i = 0; i < w; i++) {
+            if (pixel_shift)
+                sum += ((const uint16_t *)(src + j * stride))[i];
+            else
+                sum += src[j * stride + i];
+        }
+    }
+    return (sum + (w * h >> 1)) / (w * h);
+}
+
+static av_always_inline void downscale_plane(uint8_t *dst, ptrdiff_t dst_stride,
+                                             const uint8_t *src, ptrdiff_t src_stride,
+                                             int width, int height, int lowres,
+                                             int pixel_shift)
+{
+    const int size = 1 << lowres;
+    int x, y;
+
+    for (y = 0; y < height; y += size) {
+        const int h = FFMIN(size, height - y);
+
+        /* whole squares use constant sizes so that the sums get unrolled */
+        for (x = 0; x < width; x += size) {
+            const int w = FFMIN(size, width - x);
+            const uint8_t *block = src + (x << pixel_shift);
+            int val;
+
+            if (w == size && h == size)
+                val = downscale_block(block, src_stride, size, size, pixel_shift);
+            else
+                val = downscale_block(block, src_stride, w, h, pixel_shift);
+            if (pixel_shift)
+                ((uint16_t *)dst)[x >> lowres] = val;
+            else
+                dst[x >> lowres] = val;
+        }
+        src += size * src_stride;
+        dst += dst_stride;
+    }
+}
+
+/**
+ * Fill the low resolution output frame of the current picture, every sample
+ * is the average of the 2^lowres x 2^lowres full resolution ones it covers.
+ */
+static void downscale_frame(HEVCContext *s)
+{
+    const HEVCSPS *sps = s->ps.sps;
+    const AVFrame *src = s->ref->frame;
+    AVFrame *dst       = s->ref->frame_lowres;
+    int c_idx;
+
+    for (c_idx = 0; c_idx < (sps->chroma_format_idc ? 3 : 1); c_idx++) {
+        const int w = sps->width  >> sps->hshift[c_idx];
+        const int h = sps->height >> sps->vshift[c_idx];
+
+#define DOWNSCALE(lowres, pixel_shift)                                          \
+        downscale_plane(dst->data[c_idx], dst->linesize[c_idx], src->data[c_idx], \
+                        src->linesize[c_idx], w, h, lowres, pixel_shift)
+        switch (s->avctx->lowres << 1 | sps->pixel_shift) {
+        case 2: DOWNSCALE(1, 0); break;
+        case 3: DOWNSCALE(1, 1); break;
+        case 4: DOWNSCALE(2, 0); break;
+        case 5: DOWNSCALE(2, 1); break;
+        case 6: DOWNSCALE(3, 0); break;
+        case 7: DOWNSCALE(3, 1); break;
+        }
+#undef DOWNSCALE
+    }
+}
+
 static int decode_nal_units(HEVCContext *s, const uint8_t *buf, int length)
 {
     int i, ret = 0;
@@ -3200,6 +3342,8 @@ static int decode_nal_units(HEVCContext *s, const uint8_t *buf, int length)
     }
 
 fail:
+    if (s->ref && s->avctx->lowres && !s->skip_recon)
+        downscale_frame(s);
     if (s->ref && s->threads_type == FF_THREAD_FRAME)
         ff_thread_report_progress(&s->ref->tf, INT_MAX, 0);
 
@@ -3344,9 +3488,10 @@ static int hevc_decode_frame(AVCodecContext *avctx, void *data, int *got_output,
             return ret;
         }
     } else {
-        /* verify the SEI checksum */
+        /* verify the SEI checksum, it does not apply to frames that were
+         * only parsed */
         if (avctx->err_recognition & AV_EF_CRCCHECK && s->is_decoded &&
-            s->sei.picture_hash.is_md5) {
+            s->sei.picture_hash.is_md5 && !s->skip_recon) {
             ret = verify_md5(s, s->ref->frame);
             if (ret < 0 && avctx->err_recognition & AV_EF_EXPLODE) {
                 ff_hevc_unref_frame(s, s->ref, ~0);
@@ -3377,6 +3522,12 @@ static int hevc_ref_frame(HEVCContext *s, HEVCFrame *dst, HEVCFrame *src)
     if (ret < 0)
         return ret;
 
+    if (src->frame_lowres->buf[0]) {
+        ret = ff_thread_ref_frame(&dst->tf_lowres, &src->tf_lowres);
+        if (ret < 0)
+            goto fail;
+    }
+
     dst->tab_mvf_buf = av_buffer_ref(src->tab_mvf_buf);
     if (!dst->tab_mvf_buf)
         goto fail;
@@ -3429,6 +3580,7 @@ static av_cold int hevc_decode_free(AVCodecContext *avctx)
     for (i = 0; i < FF_ARRAY_ELEMS(s->DPB); i++) {
         ff_hevc_unref_frame(s, &s->DPB[i], ~0);
         av_frame_free(&s->DPB[i].frame);
+        av_frame_free(&s->DPB[i].frame_lowres);
     }
 
     ff_hevc_ps_uninit(&s->ps);
@@ -3482,6 +3634,11 @@ static av_cold int hevc_init_context(AVCodecContext *avctx)
         if (!s->DPB[i].frame)
             goto fail;
         s->DPB[i].tf.f = s->DPB[i].frame;
+
+        s->DPB[i].frame_lowres = av_frame_alloc();
+        if (!s->DPB[i].frame_lowres)
+            goto fail;
+        s->DPB[i].tf_lowres.f = s->DPB[i].frame_lowres;
     }
 
     s->max_ra = INT_MAX;
@@ -3691,6 +3848,7 @@ AVCodec ff_hevc_decoder = {
     .caps_internal         = FF_CODEC_CAP_INIT_THREADSAFE | FF_CODEC_CAP_EXPORTS_CROPPING |
                              FF_CODEC_CAP_ALLOCATE_PROGRESS | FF_CODEC_CAP_INIT_CLEANUP,
     .profiles              = NULL_IF_CONFIG_SMALL(ff_hevc_profiles),
+    .max_lowres            = 3,
     .hw_configs            = (const AVCodecHWConfigInternal *const []) {
 #if CONFIG_HEVC_DXVA2_HWACCEL
                                HWACCEL_DXVA2(hevc),
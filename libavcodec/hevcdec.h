@@ -396,6 +396,11 @@ typedef struct DBParams {
 typedef struct HEVCFrame {
     AVFrame *frame;
     ThreadFrame tf;
+    /**
+     * Downscaled copy of frame, output in its place with AVCodecContext.lowres
+     */
+    AVFrame *frame_lowres;
+    ThreadFrame tf_lowres;
     MvField *tab_mvf;
     RefPicList *refPicList;
     RefPicListTab **rpl_tab;
@@ -520,6 +525,7 @@ typedef struct HEVCContext {
 
     int is_decoded;
     int no_rasl_output_flag;
+    int skip_recon;  ///< only parse the current frame, see AVCodecContext.skip_recon
 
     HEVCPredContext hpc;
     HEVCDSPContext hevcdsp;
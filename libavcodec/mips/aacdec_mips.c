@@ -120,7 +120,7 @@ static void imdct_and_windowing_mips(AACContext *ac, SingleChannelElement *sce)
     const float *swindow      = ics->use_kb_window[0] ? ff_aac_kbd_short_128 : ff_sine_128;
     const float *lwindow_prev = ics->use_kb_window[1] ? ff_aac_kbd_long_1024 : ff_sine_1024;
     const float *swindow_prev = ics->use_kb_window[1] ? ff_aac_kbd_short_128 : ff_sine_128;
-    float *buf  = ac->buf_mdct;
+    float *buf  = sce->buf_mdct;
     int i;
 
     if (ics->window_sequence[0] == EIGHT_SHORT_SEQUENCE) {
@@ -232,7 +232,7 @@ static void apply_ltp_mips(AACContext *ac, SingleChannelElement *sce)
 
     if (sce->ics.window_sequence[0] != EIGHT_SHORT_SEQUENCE) {
         float *predTime = sce->ret;
-        float *predFreq = ac->buf_mdct;
+        float *predFreq = sce->buf_mdct;
         float *p_predTime;
         int16_t num_samples = 2048;
 
@@ -367,8 +367,8 @@ static void update_ltp_mips(AACContext *ac, SingleChannelElement *sce)
             : "memory"
         );
 
-        ac->fdsp->vector_fmul_reverse(saved_ltp + 448, ac->buf_mdct + 960,     &swindow[64],      64);
-        fmul_and_reverse(saved_ltp + 512, ac->buf_mdct + 960, swindow, 64);
+        ac->fdsp->vector_fmul_reverse(saved_ltp + 448, sce->buf_mdct + 960,     &swindow[64],      64);
+        fmul_and_reverse(saved_ltp + 512, sce->buf_mdct + 960, swindow, 64);
     } else if (ics->window_sequence[0] == LONG_START_SEQUENCE) {
         float *buff0 = saved;
         float *buff1 = saved_ltp;
@@ -416,11 +416,11 @@ static void update_ltp_mips(AACContext *ac, SingleChannelElement *sce)
             : [loop_end]"r"(loop_end)
             : "memory"
         );
-        ac->fdsp->vector_fmul_reverse(saved_ltp + 448, ac->buf_mdct + 960,     &swindow[64],      64);
-        fmul_and_reverse(saved_ltp + 512, ac->buf_mdct + 960, swindow, 64);
+        ac->fdsp->vector_fmul_reverse(saved_ltp + 448, sce->buf_mdct + 960,     &swindow[64],      64);
+        fmul_and_reverse(saved_ltp + 512, sce->buf_mdct + 960, swindow, 64);
     } else { // LONG_STOP or ONLY_LONG
-        ac->fdsp->vector_fmul_reverse(saved_ltp,       ac->buf_mdct + 512,     &lwindow[512],     512);
-        fmul_and_reverse(saved_ltp + 512, ac->buf_mdct + 512, lwindow, 512);
+        ac->fdsp->vector_fmul_reverse(saved_ltp,       sce->buf_mdct + 512,     &lwindow[512],     512);
+        fmul_and_reverse(saved_ltp + 512, sce->buf_mdct + 512, lwindow, 512);
     }
 
     float_copy(sce->ltp_state, sce->ltp_state + 1024, 1024);
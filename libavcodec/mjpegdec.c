@@ -1413,17 +1413,93 @@ static void shift_output(MJpegDecodeContext *s, uint8_t *ptr, int linesize)
     }
 }
 
+static int decode_mcu(MJpegDecodeContext *s, int nb_components, int Ah, int Al,
+                      int mb_x, int mb_y, int copy_mb, const AVFrame *reference,
+                      int chroma_width, int chroma_height)
+{
+    int bytes_per_pixel = 1 + (s->bits > 8);
+    int i;
+
+    for (i = 0; i < nb_components; i++) {
+        uint8_t *ptr;
+        int n, h, v, x, y, c, j;
+        int block_offset;
+        int linesize;
+        n = s->nb_blocks[i];
+        c = s->comp_index[i];
+        h = s->h_scount[i];
+        v = s->v_scount[i];
+        x = 0;
+        y = 0;
+        linesize = s->linesize[c];
+        for (j = 0; j < n; j++) {
+            block_offset = (((linesize * (v * mb_y + y) * 8) +
+                             (h * mb_x + x) * 8 * bytes_per_pixel) >> s->avctx->lowres);
+
+            if (s->interlaced && s->bottom_field)
+                block_offset += linesize >> 1;
+            if (   8*(h * mb_x + x) < ((c == 1) || (c == 2) ? chroma_width  : s->width)
+                && 8*(v * mb_y + y) < ((c == 1) || (c == 2) ? chroma_height : s->height)) {
+                ptr = s->picture_ptr->data[c] + block_offset;
+            } else
+                ptr = NULL;
+            if (!s->progressive) {
+                if (copy_mb) {
+                    if (ptr)
+                        mjpeg_copy_block(s, ptr, reference->data[c] + block_offset,
+                                        linesize, s->avctx->lowres);
+
+                } else {
+                    s->bdsp.clear_block(s->block);
+                    if (decode_block(s, s->block, i,
+                                     s->dc_index[i], s->ac_index[i],
+                                     s->quant_matrixes[s->quant_sindex[i]]) < 0) {
+                        av_log(s->avctx, AV_LOG_ERROR,
+                               "error y=%d x=%d\n", mb_y, mb_x);
+                        return AVERROR_INVALIDDATA;
+                    }
+                    if (ptr) {
+                        s->idsp.idct_put(ptr, linesize, s->block);
+                        if (s->bits & 7)
+                            shift_output(s, ptr, linesize);
+                    }
+                }
+            } else {
+                int block_idx  = s->block_stride[c] * (v * mb_y + y) +
+                                 (h * mb_x + x);
+                int16_t *block = s->blocks[c][block_idx];
+                if (Ah)
+                    block[0] += get_bits1(&s->gb) *
+                                s->quant_matrixes[s->quant_sindex[i]][0] << Al;
+                else if (decode_dc_progressive(s, block, i, s->dc_index[i],
+                                               s->quant_matrixes[s->quant_sindex[i]],
+                                               Al) < 0) {
+                    av_log(s->avctx, AV_LOG_ERROR,
+                           "error y=%d x=%d\n", mb_y, mb_x);
+                    return AVERROR_INVALIDDATA;
+                }
+            }
+            ff_dlog(s->avctx, "mb: %d %d processed\n", mb_y, mb_x);
+            ff_dlog(s->avctx, "%d %d %d %d %d %d %d %d \n",
+                    mb_x, mb_y, x, y, c, s->bottom_field,
+                    (v * mb_y + y) * 8, (h * mb_x + x) * 8);
+            if (++x == h) {
+                x = 0;
+                y++;
+            }
+        }
+    }
+    return 0;
+}
+
 static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
                              int Al, const uint8_t *mb_bitmask,
                              int mb_bitmask_size,
                              const AVFrame *reference)
 {
     int i, mb_x, mb_y, chroma_h_shift, chroma_v_shift, chroma_width, chroma_height;
-    uint8_t *data[MAX_COMPONENTS];
-    const uint8_t *reference_data[MAX_COMPONENTS];
-    int linesize[MAX_COMPONENTS];
     GetBitContext mb_bitmask_gb = {0}; // initialize to silence gcc warning
-    int bytes_per_pixel = 1 + (s->bits > 8);
+    int ret;
 
     if (mb_bitmask) {
         if (mb_bitmask_size != (s->mb_width * s->mb_height + 7)>>3) {
@@ -1440,13 +1516,8 @@ static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
     chroma_width  = AV_CEIL_RSHIFT(s->width,  chroma_h_shift);
     chroma_height = AV_CEIL_RSHIFT(s->height, chroma_v_shift);
 
-    for (i = 0; i < nb_components; i++) {
-        int c   = s->comp_index[i];
-        data[c] = s->picture_ptr->data[c];
-        reference_data[c] = reference ? reference->data[c] : NULL;
-        linesize[c] = s->linesize[c];
-        s->coefs_finished[c] |= 1;
-    }
+    for (i = 0; i < nb_components; i++)
+        s->coefs_finished[s->comp_index[i]] |= 1;
 
     for (mb_y = 0; mb_y < s->mb_height; mb_y++) {
         for (mb_x = 0; mb_x < s->mb_width; mb_x++) {
@@ -1460,73 +1531,10 @@ static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
                        -get_bits_left(&s->gb));
                 return AVERROR_INVALIDDATA;
             }
-            for (i = 0; i < nb_components; i++) {
-                uint8_t *ptr;
-                int n, h, v, x, y, c, j;
-                int block_offset;
-                n = s->nb_blocks[i];
-                c = s->comp_index[i];
-                h = s->h_scount[i];
-                v = s->v_scount[i];
-                x = 0;
-                y = 0;
-                for (j = 0; j < n; j++) {
-                    block_offset = (((linesize[c] * (v * mb_y + y) * 8) +
-                                     (h * mb_x + x) * 8 * bytes_per_pixel) >> s->avctx->lowres);
-
-                    if (s->interlaced && s->bottom_field)
-                        block_offset += linesize[c] >> 1;
-                    if (   8*(h * mb_x + x) < ((c == 1) || (c == 2) ? chroma_width  : s->width)
-                        && 8*(v * mb_y + y) < ((c == 1) || (c == 2) ? chroma_height : s->height)) {
-                        ptr = data[c] + block_offset;
-                    } else
-                        ptr = NULL;
-                    if (!s->progressive) {
-                        if (copy_mb) {
-                            if (ptr)
-                                mjpeg_copy_block(s, ptr, reference_data[c] + block_offset,
-                                                linesize[c], s->avctx->lowres);
-
-                        } else {
-                            s->bdsp.clear_block(s->block);
-                            if (decode_block(s, s->block, i,
-                                             s->dc_index[i], s->ac_index[i],
-                                             s->quant_matrixes[s->quant_sindex[i]]) < 0) {
-                                av_log(s->avctx, AV_LOG_ERROR,
-                                       "error y=%d x=%d\n", mb_y, mb_x);
-                                return AVERROR_INVALIDDATA;
-                            }
-                            if (ptr) {
-                                s->idsp.idct_put(ptr, linesize[c], s->block);
-                                if (s->bits & 7)
-                                    shift_output(s, ptr, linesize[c]);
-                            }
-                        }
-                    } else {
-                        int block_idx  = s->block_stride[c] * (v * mb_y + y) +
-                                         (h * mb_x + x);
-                        int16_t *block = s->blocks[c][block_idx];
-                        if (Ah)
-                            block[0] += get_bits1(&s->gb) *
-                                        s->quant_matrixes[s->quant_sindex[i]][0] << Al;
-                        else if (decode_dc_progressive(s, block, i, s->dc_index[i],
-                                                       s->quant_matrixes[s->quant_sindex[i]],
-                                                       Al) < 0) {
-                            av_log(s->avctx, AV_LOG_ERROR,
-                                   "error y=%d x=%d\n", mb_y, mb_x);
-                            return AVERROR_INVALIDDATA;
-                        }
-                    }
-                    ff_dlog(s->avctx, "mb: %d %d processed\n", mb_y, mb_x);
-                    ff_dlog(s->avctx, "%d %d %d %d %d %d %d %d \n",
-                            mb_x, mb_y, x, y, c, s->bottom_field,
-                            (v * mb_y + y) * 8, (h * mb_x + x) * 8);
-                    if (++x == h) {
-                        x = 0;
-                        y++;
-                    }
-                }
-            }
+            ret = decode_mcu(s, nb_components, Ah, Al, mb_x, mb_y, copy_mb,
+                             reference, chroma_width, chroma_height);
+            if (ret < 0)
+                return ret;
 
             handle_rstn(s, nb_components);
         }
@@ -1534,6 +1542,139 @@ static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
     return 0;
 }
 
+/**
+ * Locate the restart markers of the current baseline scan, so that the
+ * restart intervals can be decoded in parallel.
+ *
+ * @return number of restart intervals, or 0 if the scan is to be decoded
+ *         sequentially
+ */
+static int find_restart_intervals(MJpegDecodeContext *s)
+{
+    AVCodecContext *avctx = s->avctx;
+    const int mcu_count   = s->mb_width * s->mb_height;
+    const uint8_t *buf    = s->raw_scan_buffer;
+    const int buf_size    = s->raw_scan_buffer_size;
+    int nb_intervals, pos, unescaped_pos, n = 1;
+
+    if (!(avctx->active_thread_type & FF_THREAD_SLICE) || avctx->thread_count <= 1 ||
+        avctx->codec_id != AV_CODEC_ID_MJPEG || s->interlaced ||
+        !s->restart_interval || s->restart_interval >= mcu_count)
+        return 0;
+
+    nb_intervals = (mcu_count + s->restart_interval - 1) / s->restart_interval;
+    av_fast_malloc(&s->restart_offsets, &s->restart_offsets_size,
+                   (nb_intervals + 1) * sizeof(*s->restart_offsets));
+    if (!s->restart_offsets)
+        return 0;
+
+    /* The unescaped scan data only differs from the raw data by the
+     * removed stuffing bytes, but only the raw data tells restart markers
+     * and stuffed 0xFF bytes apart. */
+    pos = unescaped_pos = get_bits_count(&s->gb) / 8;
+    s->restart_offsets[0] = unescaped_pos;
+    while (pos < buf_size) {
+        if (buf[pos++] != 0xFF) {
+            unescaped_pos++;
+            continue;
+        }
+        if (pos >= buf_size)
+            return 0;
+        if (!buf[pos]) {
+            pos++;
+            unescaped_pos++;
+        } else if (buf[pos] >= RST0 && buf[pos] <= RST7) {
+            if (n == nb_intervals)
+                return 0;
+            pos++;
+            unescaped_pos += 2;
+            s->restart_offsets[n++] = unescaped_pos;
+        } else if (buf[pos] == 0xFF) {
+            /* fill bytes are rare here, leave them to the sequential path */
+            return 0;
+        } else {
+            break;
+        }
+    }
+    if (n != nb_intervals)
+        return 0;
+    /* so that every interval ends 2 bytes before the next one starts */
+    s->restart_offsets[n] = unescaped_pos + 2;
+
+    return nb_intervals;
+}
+
+static int decode_restart_interval(AVCodecContext *avctx, void *arg,
+                                   int jobnr, int threadnr)
+{
+    MJpegDecodeContext *s0 = avctx->priv_data;
+    MJpegDecodeContext *s  = &s0->slice_ctx[threadnr];
+    const int nb_components = *(int *)arg;
+    const int mcu_count = s->mb_width * s->mb_height;
+    const int start = jobnr * s->restart_interval;
+    const int end   = FFMIN(start + s->restart_interval, mcu_count);
+    const int offset = s0->restart_offsets[jobnr];
+    int chroma_h_shift, chroma_v_shift, chroma_width, chroma_height;
+    int i, mcu, ret;
+
+    av_pix_fmt_get_chroma_sub_sample(avctx->pix_fmt, &chroma_h_shift,
+                                     &chroma_v_shift);
+    chroma_width  = AV_CEIL_RSHIFT(s->width,  chroma_h_shift);
+    chroma_height = AV_CEIL_RSHIFT(s->height, chroma_v_shift);
+
+    ret = init_get_bits8(&s->gb, s0->gb.buffer + offset,
+                         s0->restart_offsets[jobnr + 1] - 2 - offset);
+    if (ret < 0)
+        return ret;
+
+    for (i = 0; i < nb_components; i++)
+        s->last_dc[i] = (4 << s->bits);
+
+    for (mcu = start; mcu < end; mcu++) {
+        if (get_bits_left(&s->gb) < 0) {
+            av_log(avctx, AV_LOG_ERROR, "overread %d\n",
+                   -get_bits_left(&s->gb));
+            return AVERROR_INVALIDDATA;
+        }
+        ret = decode_mcu(s, nb_components, 0, 0, mcu % s->mb_width,
+                         mcu / s->mb_width, 0, NULL, chroma_width, chroma_height);
+        if (ret < 0)
+            return ret;
+    }
+    return 0;
+}
+
+static int mjpeg_decode_scan_slices(MJpegDecodeContext *s, int nb_components,
+                                    int nb_intervals)
+{
+    AVCodecContext *avctx = s->avctx;
+    int i;
+
+    av_fast_malloc(&s->slice_ctx, &s->slice_ctx_size,
+                   avctx->thread_count * sizeof(*s->slice_ctx));
+    av_fast_malloc(&s->restart_ret, &s->restart_ret_size,
+                   nb_intervals * sizeof(*s->restart_ret));
+    if (!s->slice_ctx || !s->restart_ret)
+        return AVERROR(ENOMEM);
+
+    /* shallow copies, each thread only changes its bit reader, DC
+     * predictors and block buffer */
+    for (i = 0; i < avctx->thread_count; i++)
+        s->slice_ctx[i] = *s;
+
+    avctx->execute2(avctx, decode_restart_interval, &nb_components,
+                    s->restart_ret, nb_intervals);
+
+    /* continue after the scan, like the sequential decoder does */
+    skip_bits_long(&s->gb, (s->restart_offsets[nb_intervals] - 2) * 8 -
+                   get_bits_count(&s->gb));
+
+    for (i = 0; i < nb_intervals; i++)
+        if (s->restart_ret[i] < 0)
+            return s->restart_ret[i];
+    return 0;
+}
+
 static int mjpeg_decode_scan_progressive_ac(MJpegDecodeContext *s, int ss,
                                             int se, int Ah, int Al)
 {
@@ -1770,9 +1911,16 @@ next_field:
                                                         point_transform)) < 0)
                 return ret;
         } else {
-            if ((ret = mjpeg_decode_scan(s, nb_components,
-                                         prev_shift, point_transform,
-                                         mb_bitmask, mb_bitmask_size, reference)) < 0)
+            int nb_intervals = 0;
+
+            if (!s->progressive && !mb_bitmask)
+                nb_intervals = find_restart_intervals(s);
+            if (nb_intervals > 1) {
+                if ((ret = mjpeg_decode_scan_slices(s, nb_components, nb_intervals)) < 0)
+                    return ret;
+            } else if ((ret = mjpeg_decode_scan(s, nb_components,
+                                                prev_shift, point_transform,
+                                                mb_bitmask, mb_bitmask_size, reference)) < 0)
                 return ret;
         }
     }
@@ -2898,6 +3046,9 @@ av_cold int ff_mjpeg_decode_end(AVCodecContext *avctx)
     av_frame_free(&s->smv_frame);
 
     av_freep(&s->buffer);
+    av_freep(&s->restart_offsets);
+    av_freep(&s->restart_ret);
+    av_freep(&s->slice_ctx);
     av_freep(&s->stereo3d);
     av_freep(&s->ljpeg_buffer);
     s->ljpeg_buffer_size = 0;
@@ -2954,7 +3105,7 @@ AVCodec ff_mjpeg_decoder = {
     .close          = ff_mjpeg_decode_end,
     .receive_frame  = ff_mjpeg_receive_frame,
     .flush          = decode_flush,
-    .capabilities   = AV_CODEC_CAP_DR1,
+    .capabilities   = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_SLICE_THREADS,
     .max_lowres     = 3,
     .priv_class     = &mjpegdec_class,
     .profiles       = NULL_IF_CONFIG_SMALL(ff_mjpeg_profiles),
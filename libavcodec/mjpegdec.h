@@ -122,6 +122,12 @@ typedef struct MJpegDecodeContext {
 
     int restart_interval;
     int restart_count;
+    int *restart_offsets;       ///< start of each restart interval in the unescaped scan
+    unsigned int restart_offsets_size;
+    int *restart_ret;
+    unsigned int restart_ret_size;
+    struct MJpegDecodeContext *slice_ctx; ///< per-thread contexts for restart interval decoding
+    unsigned int slice_ctx_size;
 
     int buggy_avid;
     int cs_itu601;
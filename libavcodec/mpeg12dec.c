@@ -2073,6 +2073,9 @@ static int slice_end(AVCodecContext *avctx, AVFrame *pict)
                 int ret = av_frame_ref(pict, s->last_picture_ptr->f);
                 if (ret < 0)
                     return ret;
+                /* the MB tables of the last picture are exported, it must be
+                 * completely decoded even if nothing of it has been referenced */
+                ff_thread_await_progress(&s->last_picture_ptr->tf, INT_MAX, 0);
                 ff_print_debug_info(s, s->last_picture_ptr, pict);
                 ff_mpv_export_qp_table(s, pict, s->last_picture_ptr, FF_QSCALE_TYPE_MPEG2);
             }
@@ -2008,6 +2008,14 @@ void mpv_reconstruct_mb_internal(MpegEncContext *s, int16_t block[12][64],
             } else{
                 *mbskip_ptr = 0; /* not skipped */
             }
+
+            /* only parse the MB, see AVCodecContext.skip_recon */
+            if (s->avctx->skip_recon) {
+                if(  (s->avctx->skip_recon >= AVDISCARD_NONREF && s->pict_type == AV_PICTURE_TYPE_B)
+                   ||(s->avctx->skip_recon >= AVDISCARD_NONKEY && s->pict_type != AV_PICTURE_TYPE_I)
+                   || s->avctx->skip_recon >= AVDISCARD_ALL)
+                    return;
+            }
         }
 
         dct_linesize = linesize << s->interlaced_dct;
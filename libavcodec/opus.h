@@ -139,6 +139,8 @@ typedef struct OpusStreamContext {
     int delayed_samples;
 
     OpusPacket packet;
+    /* start of the current sub-packet in the input packet */
+    const uint8_t *packet_buf;
 
     int redundancy_idx;
 } OpusStreamContext;
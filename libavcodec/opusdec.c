@@ -411,6 +411,19 @@ finish:
     return output_samples;
 }
 
+static int opus_decode_substream(AVCodecContext *avctx, void *arg,
+                                 int jobnr, int threadnr)
+{
+    OpusContext       *c = avctx->priv_data;
+    OpusStreamContext *s = &c->streams[jobnr];
+    int coded_samples    = *(int *)arg;
+
+    s->decoded_samples = opus_decode_subpacket(s, s->packet_buf,
+                                               s->packet.data_size,
+                                               coded_samples);
+    return 0;
+}
+
 static int opus_decode_packet(AVCodecContext *avctx, void *data,
                               int *got_frame_ptr, AVPacket *avpkt)
 {
@@ -496,7 +509,7 @@ static int opus_decode_packet(AVCodecContext *avctx, void *data,
         s->out_size = frame->linesize[0] - ret * sizeof(float);
     }
 
-    /* decode each sub-packet */
+    /* parse the sub-packet headers */
     for (i = 0; i < c->nb_streams; i++) {
         OpusStreamContext *s = &c->streams[i];
 
@@ -515,17 +528,27 @@ static int opus_decode_packet(AVCodecContext *avctx, void *data,
             s->silk_samplerate = get_silk_samplerate(s->packet.config);
         }
 
-        ret = opus_decode_subpacket(&c->streams[i], buf, s->packet.data_size,
-                                    coded_samples);
-        if (ret < 0)
-            return ret;
-        s->decoded_samples = ret;
-        decoded_samples       = FFMIN(decoded_samples, ret);
+        s->packet_buf = buf;
 
         buf      += s->packet.packet_size;
         buf_size -= s->packet.packet_size;
     }
 
+    /* decode each sub-packet, the streams are independent of each other */
+    if (c->nb_streams > 1)
+        avctx->execute2(avctx, opus_decode_substream, &coded_samples, NULL,
+                        c->nb_streams);
+    else
+        opus_decode_substream(avctx, &coded_samples, 0, 0);
+
+    for (i = 0; i < c->nb_streams; i++) {
+        OpusStreamContext *s = &c->streams[i];
+
+        if (s->decoded_samples < 0)
+            return s->decoded_samples;
+        decoded_samples = FFMIN(decoded_samples, s->decoded_samples);
+    }
+
     /* buffer the extra samples */
     for (i = 0; i < c->nb_streams; i++) {
         OpusStreamContext *s = &c->streams[i];
@@ -715,6 +738,7 @@ AVCodec ff_opus_decoder = {
     .close           = opus_decode_close,
     .decode          = opus_decode_packet,
     .flush           = opus_decode_flush,
-    .capabilities    = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_DELAY | AV_CODEC_CAP_CHANNEL_CONF,
+    .capabilities    = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_DELAY | AV_CODEC_CAP_CHANNEL_CONF |
+                       AV_CODEC_CAP_SLICE_THREADS,
     .caps_internal   = FF_CODEC_CAP_INIT_THREADSAFE | FF_CODEC_CAP_INIT_CLEANUP,
 };
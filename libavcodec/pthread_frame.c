@@ -358,6 +358,7 @@ static int update_context_from_user(AVCodecContext *dst, AVCodecContext *src)
     dst->skip_loop_filter = src->skip_loop_filter;
     dst->skip_idct        = src->skip_idct;
     dst->skip_frame       = src->skip_frame;
+    dst->skip_recon       = src->skip_recon;
 
     dst->frame_number     = src->frame_number;
     dst->reordered_opaque = src->reordered_opaque;
@@ -346,8 +346,9 @@ typedef struct VC1Context{
     int fieldtx_is_raw;
     uint8_t zzi_8x8[64];
     uint8_t *blk_mv_type_base, *blk_mv_type;    ///< 0: frame MV, 1: field MV (interlaced frame)
-    uint8_t *mv_f_base, *mv_f[2];               ///< 0: MV obtained from same field, 1: opposite field
-    uint8_t *mv_f_next_base, *mv_f_next[2];
+    AVBufferRef *mv_f_buf, *mv_f_next_buf;      ///< backing store of mv_f[] and mv_f_next[], shared between frame threads
+    uint8_t *mv_f[2];                           ///< 0: MV obtained from same field, 1: opposite field
+    uint8_t *mv_f_next[2];
     int field_mode;         ///< 1 for interlaced field pictures
     int fptype;
     int second_field;
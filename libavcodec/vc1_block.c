@@ -30,6 +30,7 @@
 #include "mpegutils.h"
 #include "mpegvideo.h"
 #include "msmpeg4data.h"
+#include "thread.h"
 #include "unary.h"
 #include "vc1.h"
 #include "vc1_pred.h"
@@ -69,6 +70,53 @@ static inline void init_block_index(VC1Context *v)
 
 /** @} */ //Bitplane group
 
+/**
+ * Wait until the reference pictures are final down to the lowest MB row the
+ * motion vectors of the current MB row can reach. P picture MVs are bounded
+ * by the MV range of the picture, B pictures take scaled MVs from the next
+ * anchor and field pictures are only released as a whole, so those wait for
+ * their references to be fully decoded.
+ */
+static void vc1_await_references(VC1Context *v)
+{
+    MpegEncContext *s = &v->s;
+    int row = INT_MAX;
+
+    if (!(s->avctx->active_thread_type & FF_THREAD_FRAME))
+        return;
+
+    if (s->pict_type == AV_PICTURE_TYPE_P && !v->field_mode) {
+        /* range_y is in quarter samples, add the MB height and the taps of
+         * the interpolation filters */
+        int lines = (v->range_y >> 2) + 18;
+        if (v->fcm == ILACE_FRAME)
+            lines *= 2;
+        row = FFMIN(s->mb_y + (lines >> 4), s->mb_height - 1);
+    }
+
+    if (s->last_picture_ptr && s->last_picture_ptr != s->current_picture_ptr)
+        ff_thread_await_progress(&s->last_picture_ptr->tf, row, 0);
+    if (s->pict_type == AV_PICTURE_TYPE_B &&
+        s->next_picture_ptr && s->next_picture_ptr != s->current_picture_ptr)
+        ff_thread_await_progress(&s->next_picture_ptr->tf, row, 0);
+}
+
+/**
+ * Report the MB rows of a reference picture that are final once the
+ * decoding loop is done with row mb_y. Pixels are put one row behind the
+ * decoding loop and the loop filter trails by two rows while touching the
+ * bottom lines of the row above, so the last three rows are not final yet.
+ * Field pictures are reported when the whole frame is done.
+ */
+static void vc1_report_progress(VC1Context *v)
+{
+    MpegEncContext *s = &v->s;
+
+    if (s->pict_type != AV_PICTURE_TYPE_B && !v->field_mode &&
+        !s->er.error_occurred && s->mb_y >= 3)
+        ff_thread_report_progress(&s->current_picture_ptr->tf, s->mb_y - 3, 0);
+}
+
 static void vc1_put_blocks_clamped(VC1Context *v, int put_signed)
 {
     MpegEncContext *s = &v->s;
@@ -2636,6 +2684,7 @@ static void vc1_decode_i_blocks(VC1Context *v)
             ff_mpeg_draw_horiz_band(s, s->mb_y * 16, 16);
         else if (s->mb_y)
             ff_mpeg_draw_horiz_band(s, (s->mb_y - 1) * 16, 16);
+        vc1_report_progress(v);
 
         s->first_slice_line = 0;
     }
@@ -2782,6 +2831,7 @@ static int vc1_decode_i_blocks_adv(VC1Context *v)
             ff_mpeg_draw_horiz_band(s, s->mb_y * 16, 16);
         else if (s->mb_y)
             ff_mpeg_draw_horiz_band(s, (s->mb_y-1) * 16, 16);
+        vc1_report_progress(v);
         s->first_slice_line = 0;
     }
 
@@ -2828,6 +2878,7 @@ static void vc1_decode_p_blocks(VC1Context *v)
     for (s->mb_y = s->start_mb_y; s->mb_y < s->end_mb_y; s->mb_y++) {
         s->mb_x = 0;
         init_block_index(v);
+        vc1_await_references(v);
         for (; s->mb_x < s->mb_width; s->mb_x++) {
             ff_update_block_index(s);
 
@@ -2876,6 +2927,7 @@ static void vc1_decode_p_blocks(VC1Context *v)
                 sizeof(v->luma_mv_base[0]) * 2 * s->mb_stride);
         if (s->mb_y != s->start_mb_y)
             ff_mpeg_draw_horiz_band(s, (s->mb_y - 1) * 16, 16);
+        vc1_report_progress(v);
         s->first_slice_line = 0;
     }
     if (s->end_mb_y >= s->start_mb_y)
@@ -2917,6 +2969,7 @@ static void vc1_decode_b_blocks(VC1Context *v)
     for (s->mb_y = s->start_mb_y; s->mb_y < s->end_mb_y; s->mb_y++) {
         s->mb_x = 0;
         init_block_index(v);
+        vc1_await_references(v);
         for (; s->mb_x < s->mb_width; s->mb_x++) {
             ff_update_block_index(s);
 
@@ -2981,10 +3034,12 @@ static void vc1_decode_skip_blocks(VC1Context *v)
         s->mb_x = 0;
         init_block_index(v);
         ff_update_block_index(s);
+        vc1_await_references(v);
         memcpy(s->dest[0], s->last_picture.f->data[0] + s->mb_y * 16 * s->linesize,   s->linesize   * 16);
         memcpy(s->dest[1], s->last_picture.f->data[1] + s->mb_y *  8 * s->uvlinesize, s->uvlinesize *  8);
         memcpy(s->dest[2], s->last_picture.f->data[2] + s->mb_y *  8 * s->uvlinesize, s->uvlinesize *  8);
         ff_mpeg_draw_horiz_band(s, s->mb_y * 16, 16);
+        vc1_report_progress(v);
         s->first_slice_line = 0;
     }
     s->pict_type = AV_PICTURE_TYPE_P;
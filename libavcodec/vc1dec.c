@@ -36,6 +36,7 @@
 #include "msmpeg4.h"
 #include "msmpeg4data.h"
 #include "profiles.h"
+#include "thread.h"
 #include "vc1.h"
 #include "vc1data.h"
 #include "libavutil/avassert.h"
@@ -321,6 +322,13 @@ static void vc1_sprite_flush(AVCodecContext *avctx)
 
 #endif
 
+/* mv_f[0] and mv_f[1] occupy the two halves of one buffer. */
+static void set_mv_f_planes(uint8_t *mv_f[2], const AVBufferRef *buf, int b8_stride)
+{
+    mv_f[0] = buf->data + b8_stride + 1;
+    mv_f[1] = mv_f[0] + buf->size / 2;
+}
+
 av_cold int ff_vc1_decode_init_alloc_tables(VC1Context *v)
 {
     MpegEncContext *s = &v->s;
@@ -370,16 +378,14 @@ av_cold int ff_vc1_decode_init_alloc_tables(VC1Context *v)
     if (!v->blk_mv_type_base)
         goto error;
     v->blk_mv_type      = v->blk_mv_type_base + s->b8_stride + 1;
-    v->mv_f_base        = av_mallocz(2 * (s->b8_stride * (mb_height * 2 + 1) + s->mb_stride * (mb_height + 1) * 2));
-    if (!v->mv_f_base)
+    v->mv_f_buf         = av_buffer_allocz(2 * (s->b8_stride * (mb_height * 2 + 1) + s->mb_stride * (mb_height + 1) * 2));
+    if (!v->mv_f_buf)
         goto error;
-    v->mv_f[0]          = v->mv_f_base + s->b8_stride + 1;
-    v->mv_f[1]          = v->mv_f[0] + (s->b8_stride * (mb_height * 2 + 1) + s->mb_stride * (mb_height + 1) * 2);
-    v->mv_f_next_base   = av_mallocz(2 * (s->b8_stride * (mb_height * 2 + 1) + s->mb_stride * (mb_height + 1) * 2));
-    if (!v->mv_f_next_base)
+    set_mv_f_planes(v->mv_f, v->mv_f_buf, s->b8_stride);
+    v->mv_f_next_buf    = av_buffer_allocz(2 * (s->b8_stride * (mb_height * 2 + 1) + s->mb_stride * (mb_height + 1) * 2));
+    if (!v->mv_f_next_buf)
         goto error;
-    v->mv_f_next[0]     = v->mv_f_next_base + s->b8_stride + 1;
-    v->mv_f_next[1]     = v->mv_f_next[0] + (s->b8_stride * (mb_height * 2 + 1) + s->mb_stride * (mb_height + 1) * 2);
+    set_mv_f_planes(v->mv_f_next, v->mv_f_next_buf, s->b8_stride);
 
     if (s->avctx->codec_id == AV_CODEC_ID_WMV3IMAGE || s->avctx->codec_id == AV_CODEC_ID_VC1IMAGE) {
         for (i = 0; i < 4; i++)
@@ -605,8 +611,8 @@ av_cold int ff_vc1_decode_end(AVCodecContext *avctx)
     av_freep(&v->over_flags_plane);
     av_freep(&v->mb_type_base);
     av_freep(&v->blk_mv_type_base);
-    av_freep(&v->mv_f_base);
-    av_freep(&v->mv_f_next_base);
+    av_buffer_unref(&v->mv_f_buf);
+    av_buffer_unref(&v->mv_f_next_buf);
     av_freep(&v->block);
     av_freep(&v->cbp_base);
     av_freep(&v->ttblk_base);
@@ -631,6 +637,7 @@ static int vc1_decode_frame(AVCodecContext *avctx, void *data,
     uint8_t *buf2 = NULL;
     const uint8_t *buf_start = buf, *buf_start_second_field = NULL;
     int mb_height, n_slices1=-1;
+    int frame_started = 0;
     struct {
         uint8_t *buf;
         GetBitContext gb;
@@ -880,6 +887,7 @@ static int vc1_decode_frame(AVCodecContext *avctx, void *data,
     if ((ret = ff_mpv_frame_start(s, avctx)) < 0) {
         goto err;
     }
+    frame_started = 1;
 
     v->s.current_picture_ptr->field_picture = v->field_mode;
     v->s.current_picture_ptr->f->interlaced_frame = (v->fcm != PROGRESSIVE);
@@ -901,6 +909,8 @@ static int vc1_decode_frame(AVCodecContext *avctx, void *data,
     s->me.qpel_avg = s->qdsp.avg_qpel_pixels_tab;
 
     if (avctx->hwaccel) {
+        ff_thread_finish_setup(avctx);
+
         s->mb_y = 0;
         if (v->field_mode && buf_start_second_field) {
             // decode first field
@@ -1023,7 +1033,31 @@ static int vc1_decode_frame(AVCodecContext *avctx, void *data,
                 goto err;
         }
     } else {
-        int header_ret = 0;
+        int header_ret = 0, last_header = 0;
+
+        /* The field flags of an anchor field pair become the mv_f_next[] of
+         * the following B fields. Swap before the setup phase ends so that the
+         * next frame thread picks them up; only B fields read mv_f_next[].
+         * Another frame thread may still read the old contents. */
+        if (v->field_mode && s->pict_type != AV_PICTURE_TYPE_B &&
+            s->pict_type != AV_PICTURE_TYPE_BI) {
+            FFSWAP(AVBufferRef *, v->mv_f_next_buf, v->mv_f_buf);
+            if ((ret = av_buffer_make_writable(&v->mv_f_next_buf)) < 0)
+                goto err;
+            set_mv_f_planes(v->mv_f_next, v->mv_f_next_buf, s->b8_stride);
+            set_mv_f_planes(v->mv_f,      v->mv_f_next_buf, s->b8_stride);
+        } else {
+            if ((ret = av_buffer_make_writable(&v->mv_f_buf)) < 0)
+                goto err;
+            set_mv_f_planes(v->mv_f, v->mv_f_buf, s->b8_stride);
+        }
+
+        /* The second field header and picture headers repeated in slices
+         * update state inherited by the next frame thread, so the setup
+         * phase only ends once the last of them has been parsed. */
+        for (i = 1; i <= n_slices; i++)
+            if ((v->field_mode && i == n_slices1 + 2) || show_bits1(&slices[i - 1].gb))
+                last_header = i;
 
         ff_mpeg_er_frame_start(s);
 
@@ -1079,6 +1113,8 @@ static int vc1_decode_frame(AVCodecContext *avctx, void *data,
             }
             if (header_ret < 0)
                 continue;
+            if (i == last_header)
+                ff_thread_finish_setup(avctx);
             s->start_mb_y = (i == 0) ? 0 : FFMAX(0, slices[i-1].mby_start % mb_height);
             if (!v->field_mode || v->second_field)
                 s->end_mb_y = (i == n_slices     ) ? mb_height : FFMIN(mb_height, slices[i].mby_start % mb_height);
@@ -1111,10 +1147,6 @@ static int vc1_decode_frame(AVCodecContext *avctx, void *data,
             s->current_picture.f->linesize[2] >>= 1;
             s->linesize                      >>= 1;
             s->uvlinesize                    >>= 1;
-            if (v->s.pict_type != AV_PICTURE_TYPE_BI && v->s.pict_type != AV_PICTURE_TYPE_B) {
-                FFSWAP(uint8_t *, v->mv_f_next[0], v->mv_f[0]);
-                FFSWAP(uint8_t *, v->mv_f_next[1], v->mv_f[1]);
-            }
         }
         ff_dlog(s->avctx, "Consumed %i/%i bits\n",
                 get_bits_count(&s->gb), s->gb.size_in_bits);
@@ -1129,6 +1161,7 @@ static int vc1_decode_frame(AVCodecContext *avctx, void *data,
     }
 
     ff_mpv_frame_end(s);
+    frame_started = 0;
 
     if (avctx->codec_id == AV_CODEC_ID_WMV3IMAGE || avctx->codec_id == AV_CODEC_ID_VC1IMAGE) {
 image:
@@ -1170,6 +1203,9 @@ end:
     return buf_size;
 
 err:
+    /* other frame threads may be waiting on the picture */
+    if (frame_started)
+        ff_thread_report_progress(&s->current_picture_ptr->tf, INT_MAX, 0);
     av_free(buf2);
     for (i = 0; i < n_slices; i++)
         av_free(slices[i].buf);
@@ -1178,6 +1214,132 @@ err:
 }
 
 
+#if HAVE_THREADS
+static int vc1_update_thread_context(AVCodecContext *dst,
+                                     const AVCodecContext *src)
+{
+    VC1Context *v = dst->priv_data;
+    const VC1Context *v1 = src->priv_data;
+    MpegEncContext *s = &v->s;
+    const MpegEncContext *s1 = &v1->s;
+    int ret;
+
+    if (dst == src)
+        return 0;
+
+    /* The VC-1 specific tables have to follow the MpegEncContext, so set up
+     * the whole context here instead of leaving it to
+     * ff_mpeg_update_thread_context(). */
+    if (s->context_initialized &&
+        (!s1->context_initialized || s->width != s1->width || s->height != s1->height))
+        ff_vc1_decode_end(dst);
+    if (!s->context_initialized && s1->context_initialized) {
+        if ((ret = ff_msmpeg4_decode_init(dst)) < 0)
+            return ret;
+        if ((ret = ff_vc1_decode_init_alloc_tables(v)) < 0) {
+            ff_mpv_common_end(s);
+            return ret;
+        }
+    }
+
+    if ((ret = ff_mpeg_update_thread_context(dst, src)) < 0)
+        return ret;
+    if (!s1->context_initialized)
+        return 0;
+
+    s->h_edge_pos  = s1->h_edge_pos;
+    s->v_edge_pos  = s1->v_edge_pos;
+    s->loop_filter = s1->loop_filter;
+
+    /* sequence header state */
+    v->profile          = v1->profile;
+    v->level            = v1->level;
+    v->res_sprite       = v1->res_sprite;
+    v->res_y411         = v1->res_y411;
+    v->res_x8           = v1->res_x8;
+    v->multires         = v1->multires;
+    v->res_fasttx       = v1->res_fasttx;
+    v->res_transtab     = v1->res_transtab;
+    v->res_rtm_flag     = v1->res_rtm_flag;
+    v->resync_marker    = v1->resync_marker;
+    v->rangered         = v1->rangered;
+    v->chromaformat     = v1->chromaformat;
+    v->frmrtq_postproc  = v1->frmrtq_postproc;
+    v->bitrtq_postproc  = v1->bitrtq_postproc;
+    v->postprocflag     = v1->postprocflag;
+    v->max_coded_width  = v1->max_coded_width;
+    v->max_coded_height = v1->max_coded_height;
+    v->broadcast        = v1->broadcast;
+    v->interlace        = v1->interlace;
+    v->tfcntrflag       = v1->tfcntrflag;
+    v->finterpflag      = v1->finterpflag;
+    v->psf              = v1->psf;
+    v->color_prim       = v1->color_prim;
+    v->transfer_char    = v1->transfer_char;
+    v->matrix_coef      = v1->matrix_coef;
+    v->hrd_param_flag   = v1->hrd_param_flag;
+    v->hrd_num_leaky_buckets = v1->hrd_num_leaky_buckets;
+    v->zz_8x4           = v1->zz_8x4;
+    v->zz_4x8           = v1->zz_4x8;
+    dst->max_b_frames   = src->max_b_frames;
+
+    /* entry point header */
+    v->broken_link      = v1->broken_link;
+    v->closed_entry     = v1->closed_entry;
+    v->panscanflag      = v1->panscanflag;
+    v->refdist_flag     = v1->refdist_flag;
+    v->fastuvmc         = v1->fastuvmc;
+    v->extended_mv      = v1->extended_mv;
+    v->extended_dmv     = v1->extended_dmv;
+    v->dquant           = v1->dquant;
+    v->vstransform      = v1->vstransform;
+    v->overlap          = v1->overlap;
+    v->quantizer_mode   = v1->quantizer_mode;
+    v->range_mapy_flag  = v1->range_mapy_flag;
+    v->range_mapy       = v1->range_mapy;
+    v->range_mapuv_flag = v1->range_mapuv_flag;
+    v->range_mapuv      = v1->range_mapuv;
+
+    /* picture header elements that are not coded in every picture */
+    v->rnd     = v1->rnd;
+    v->tff     = v1->tff;
+    v->rff     = v1->rff;
+    v->rptfrm  = v1->rptfrm;
+    v->refdist = v1->refdist;
+    v->mvrange = v1->mvrange;
+    v->respic  = v1->respic;
+
+    /* intensity compensation state of the reference pictures, only used by
+     * the software decoder and still updated by the second field header
+     * after the setup phase when decoding with a hwaccel */
+    if (!src->hwaccel) {
+        memcpy(v->last_luty,  v1->last_luty,  sizeof(v->last_luty));
+        memcpy(v->last_lutuv, v1->last_lutuv, sizeof(v->last_lutuv));
+        memcpy(v->next_luty,  v1->next_luty,  sizeof(v->next_luty));
+        memcpy(v->next_lutuv, v1->next_lutuv, sizeof(v->next_lutuv));
+        memcpy(v->aux_luty,   v1->aux_luty,   sizeof(v->aux_luty));
+        memcpy(v->aux_lutuv,  v1->aux_lutuv,  sizeof(v->aux_lutuv));
+        v->last_use_ic = v1->last_use_ic;
+        v->next_use_ic = v1->next_use_ic;
+        v->aux_use_ic  = v1->aux_use_ic;
+        if (v1->curr_luty) {
+            int aux = v1->curr_luty == v1->aux_luty;
+            v->curr_luty   = aux ? v->aux_luty    : v->next_luty;
+            v->curr_lutuv  = aux ? v->aux_lutuv   : v->next_lutuv;
+            v->curr_use_ic = aux ? &v->aux_use_ic : &v->next_use_ic;
+        }
+    }
+
+    /* Direct mode in B field pictures reads the field flags of the next
+     * anchor, which are final once the anchor picture is */
+    if ((ret = av_buffer_replace(&v->mv_f_next_buf, v1->mv_f_next_buf)) < 0)
+        return ret;
+    set_mv_f_planes(v->mv_f_next, v->mv_f_next_buf, s->b8_stride);
+
+    return 0;
+}
+#endif
+
 static const enum AVPixelFormat vc1_hwaccel_pixfmt_list_420[] = {
 #if CONFIG_VC1_DXVA2_HWACCEL
     AV_PIX_FMT_DXVA2_VLD,
@@ -1209,7 +1371,10 @@ AVCodec ff_vc1_decoder = {
     .close          = ff_vc1_decode_end,
     .decode         = vc1_decode_frame,
     .flush          = ff_mpeg_flush,
-    .capabilities   = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_DELAY,
+    .update_thread_context = ONLY_IF_THREADS_ENABLED(vc1_update_thread_context),
+    .capabilities   = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_DELAY |
+                      AV_CODEC_CAP_FRAME_THREADS,
+    .caps_internal  = FF_CODEC_CAP_ALLOCATE_PROGRESS,
     .pix_fmts       = vc1_hwaccel_pixfmt_list_420,
     .hw_configs     = (const AVCodecHWConfigInternal *const []) {
 #if CONFIG_VC1_DXVA2_HWACCEL
@@ -1246,7 +1411,10 @@ AVCodec ff_wmv3_decoder = {
     .close          = ff_vc1_decode_end,
     .decode         = vc1_decode_frame,
     .flush          = ff_mpeg_flush,
-    .capabilities   = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_DELAY,
+    .update_thread_context = ONLY_IF_THREADS_ENABLED(vc1_update_thread_context),
+    .capabilities   = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_DELAY |
+                      AV_CODEC_CAP_FRAME_THREADS,
+    .caps_internal  = FF_CODEC_CAP_ALLOCATE_PROGRESS,
     .pix_fmts       = vc1_hwaccel_pixfmt_list_420,
     .hw_configs     = (const AVCodecHWConfigInternal *const []) {
 #if CONFIG_WMV3_DXVA2_HWACCEL
@@ -1599,12 +1599,54 @@ void ff_vorbis_inverse_coupling(float *mag, float *ang, intptr_t blocksize)
     }
 }
 
+// Dotproduct, MDCT, overlap/add and save data for next overlapping of one channel
+
+typedef struct vorbis_synth_args {
+    float **floor_ptr;
+    const uint8_t *res_chan;
+    unsigned blockflag;
+    int previous_window;
+} vorbis_synth_args;
+
+static int vorbis_synth_channel(AVCodecContext *avctx, void *arg,
+                                int j, int threadnr)
+{
+    vorbis_context *vc      = avctx->priv_data;
+    vorbis_synth_args *args = arg;
+    unsigned blockflag      = args->blockflag;
+    int previous_window     = args->previous_window;
+    unsigned blocksize      = vc->blocksize[blockflag];
+    unsigned bs0 = vc->blocksize[0];
+    unsigned bs1 = vc->blocksize[1];
+    FFTContext *mdct  = &vc->mdct[blockflag];
+    float *residue    = vc->channel_residues + args->res_chan[j] * blocksize / 2;
+    float *saved      = vc->saved + j * bs1 / 4;
+    float *ret        = args->floor_ptr[j];
+    float *buf        = residue;
+    const float *win  = vc->win[blockflag & previous_window];
+
+    vc->fdsp->vector_fmul(ret, ret, residue, blocksize / 2);
+    mdct->imdct_half(mdct, residue, ret);
+
+    if (blockflag == previous_window) {
+        vc->fdsp->vector_fmul_window(ret, saved, buf, win, blocksize / 4);
+    } else if (blockflag > previous_window) {
+        vc->fdsp->vector_fmul_window(ret, saved, buf, win, bs0 / 4);
+        memcpy(ret+bs0/2, buf+bs0/4, ((bs1-bs0)/4) * sizeof(float));
+    } else {
+        memcpy(ret, saved, ((bs1 - bs0) / 4) * sizeof(float));
+        vc->fdsp->vector_fmul_window(ret + (bs1 - bs0) / 4, saved + (bs1 - bs0) / 4, buf, win, bs0 / 4);
+    }
+    memcpy(saved, buf + blocksize / 4, blocksize / 4 * sizeof(float));
+    return 0;
+}
+
 // Decode the audio packet using the functions above
 
 static int vorbis_parse_audio_packet(vorbis_context *vc, float **floor_ptr)
 {
     GetBitContext *gb = &vc->gb;
-    FFTContext *mdct;
+    vorbis_synth_args synth_args;
     int previous_window = vc->previous_window;
     unsigned mode_number, blockflag, blocksize;
     int i, j;
@@ -1724,39 +1766,19 @@ static int vorbis_parse_audio_packet(vorbis_context *vc, float **floor_ptr)
         vc->dsp.vorbis_inverse_coupling(mag, ang, blocksize / 2);
     }
 
-// Dotproduct, MDCT
+// Dotproduct, MDCT, overlap/add, the channels are independent of each other
 
-    mdct = &vc->mdct[blockflag];
-
-    for (j = vc->audio_channels-1;j >= 0; j--) {
-        ch_res_ptr   = vc->channel_residues + res_chan[j] * blocksize / 2;
-        vc->fdsp->vector_fmul(floor_ptr[j], floor_ptr[j], ch_res_ptr, blocksize / 2);
-        mdct->imdct_half(mdct, ch_res_ptr, floor_ptr[j]);
-    }
-
-// Overlap/add, save data for next overlapping
+    synth_args.floor_ptr       = floor_ptr;
+    synth_args.res_chan        = res_chan;
+    synth_args.blockflag       = blockflag;
+    synth_args.previous_window = previous_window;
+    if (vc->audio_channels > 1)
+        vc->avctx->execute2(vc->avctx, vorbis_synth_channel, &synth_args, NULL,
+                            vc->audio_channels);
+    else
+        vorbis_synth_channel(vc->avctx, &synth_args, 0, 0);
 
     retlen = (blocksize + vc->blocksize[previous_window]) / 4;
-    for (j = 0; j < vc->audio_channels; j++) {
-        unsigned bs0 = vc->blocksize[0];
-        unsigned bs1 = vc->blocksize[1];
-        float *residue    = vc->channel_residues + res_chan[j] * blocksize / 2;
-        float *saved      = vc->saved + j * bs1 / 4;
-        float *ret        = floor_ptr[j];
-        float *buf        = residue;
-        const float *win  = vc->win[blockflag & previous_window];
-
-        if (blockflag == previous_window) {
-            vc->fdsp->vector_fmul_window(ret, saved, buf, win, blocksize / 4);
-        } else if (blockflag > previous_window) {
-            vc->fdsp->vector_fmul_window(ret, saved, buf, win, bs0 / 4);
-            memcpy(ret+bs0/2, buf+bs0/4, ((bs1-bs0)/4) * sizeof(float));
-        } else {
-            memcpy(ret, saved, ((bs1 - bs0) / 4) * sizeof(float));
-            vc->fdsp->vector_fmul_window(ret + (bs1 - bs0) / 4, saved + (bs1 - bs0) / 4, buf, win, bs0 / 4);
-        }
-        memcpy(saved, buf + blocksize / 4, blocksize / 4 * sizeof(float));
-    }
 
     vc->previous_window = blockflag;
     return retlen;
@@ -1890,7 +1912,8 @@ AVCodec ff_vorbis_decoder = {
     .close           = vorbis_decode_close,
     .decode          = vorbis_decode_frame,
     .flush           = vorbis_decode_flush,
-    .capabilities    = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_CHANNEL_CONF,
+    .capabilities    = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_CHANNEL_CONF |
+                       AV_CODEC_CAP_SLICE_THREADS,
     .caps_internal   = FF_CODEC_CAP_INIT_CLEANUP,
     .channel_layouts = ff_vorbis_channel_layouts,
     .sample_fmts     = (const enum AVSampleFormat[]) { AV_SAMPLE_FMT_FLTP,
@@ -24,7 +24,7 @@
 #include "libavutil/avstring.h"
 #include "libavutil/channel_layout.h"
 #include "libavutil/opt.h"
-#include "libavcodec/avfft.h"
+#include "libavutil/tx.h"
 #include "avfilter.h"
 #include "audio.h"
 #include "formats.h"
@@ -66,8 +66,9 @@ typedef struct DeNoiseChannel {
     double     *abs_var;
     double     *rel_var;
     double     *min_abs_var;
-    FFTComplex *fft_data;
-    FFTContext *fft, *ifft;
+    AVComplexFloat *fft_data;
+    AVTXContext *fft, *ifft;
+    av_tx_fn tx_fn, itx_fn;
 
     double      noise_band_norm[15];
     double      noise_band_avr[15];
@@ -289,52 +290,54 @@ static double limit_gain(double a, double b)
     return 1.0;
 }
 
-static void process_frame(AudioFFTDeNoiseContext *s, DeNoiseChannel *dnch,
-                          FFTComplex *fft_data,
-                          double *prior, double *prior_band_excit, int track_noise)
+/**
+ * Compute the spectral gain of the bins from start to end, the bin at
+ * fft_length2 being the Nyquist bin packed in the imaginary part of bin 0.
+ * The bins are independent, so any range of them can be computed at once.
+ */
+static void compute_gains(AudioFFTDeNoiseContext *s, DeNoiseChannel *dnch,
+                          const AVComplexFloat *fft_data, int start, int end)
+{
+    const double *abs_var = dnch->abs_var;
+    double *noisy_data = dnch->noisy_data;
+    double *clean_data = dnch->clean_data;
+    double *prior = dnch->prior;
+    double *gain = dnch->gain;
+
+    if (start == 0)
+        noisy_data[0] = fft_data[0].re * fft_data[0].re;
+    for (int i = FFMAX(start, 1); i < FFMIN(end, s->fft_length2); i++)
+        noisy_data[i] = fft_data[i].re * fft_data[i].re + fft_data[i].im * fft_data[i].im;
+    if (end > s->fft_length2)
+        noisy_data[s->fft_length2] = fft_data[0].im * fft_data[0].im;
+
+    for (int i = start; i < end; i++) {
+        const double d1 = noisy_data[i];
+        const double d2 = d1 / abs_var[i];
+        const double d3 = RATIO * prior[i] + RRATIO * fmax(d2 - 1.0, 0.0);
+        double g = d3 / (1.0 + d3);
+
+        g *= g + M_PI_4 / fmax(d2, 1.0E-6);
+        prior[i] = d2 * g;
+        clean_data[i] = d1 * g;
+        gain[i] = sqrt(g);
+    }
+}
+
+/**
+ * Update the noise estimate and spread the clean signal excitation over the
+ * bands. This needs all the bins of the channel.
+ */
+static void process_bands(AudioFFTDeNoiseContext *s, DeNoiseChannel *dnch,
+                          double *prior_band_excit, int track_noise)
 {
-    double d1, d2, d3, gain;
     int n, i1;
 
-    d1 = fft_data[0].re * fft_data[0].re;
-    dnch->noisy_data[0] = d1;
-    d2 = d1 / dnch->abs_var[0];
-    d3 = RATIO * prior[0] + RRATIO * fmax(d2 - 1.0, 0.0);
-    gain = d3 / (1.0 + d3);
-    gain *= (gain + M_PI_4 / fmax(d2, 1.0E-6));
-    prior[0] = (d2 * gain);
-    dnch->clean_data[0] = (d1 * gain);
-    gain = sqrt(gain);
-    dnch->gain[0] = gain;
-    n = 0;
-    for (int i = 1; i < s->fft_length2; i++) {
-        d1 = fft_data[i].re * fft_data[i].re + fft_data[i].im * fft_data[i].im;
-        if (d1 > s->sample_floor)
-            n = i;
-
-        dnch->noisy_data[i] = d1;
-        d2 = d1 / dnch->abs_var[i];
-        d3 = RATIO * prior[i] + RRATIO * fmax(d2 - 1.0, 0.0);
-        gain = d3 / (1.0 + d3);
-        gain *= (gain + M_PI_4 / fmax(d2, 1.0E-6));
-        prior[i] = d2 * gain;
-        dnch->clean_data[i] = d1 * gain;
-        gain = sqrt(gain);
-        dnch->gain[i] = gain;
+    for (n = s->fft_length2; n > 0; n--) {
+        if (dnch->noisy_data[n] > s->sample_floor)
+            break;
     }
-    d1 = fft_data[0].im * fft_data[0].im;
-    if (d1 > s->sample_floor)
-        n = s->fft_length2;
-
-    dnch->noisy_data[s->fft_length2] = d1;
-    d2 = d1 / dnch->abs_var[s->fft_length2];
-    d3 = RATIO * prior[s->fft_length2] + RRATIO * fmax(d2 - 1.0, 0.0);
-    gain = d3 / (1.0 + d3);
-    gain *= gain + M_PI_4 / fmax(d2, 1.0E-6);
-    prior[s->fft_length2] = d2 * gain;
-    dnch->clean_data[s->fft_length2] = d1 * gain;
-    gain = sqrt(gain);
-    dnch->gain[s->fft_length2] = gain;
+
     if (n > s->fft_length2 - 2) {
         n = s->bin_count;
         i1 = s->noise_band_count;
@@ -436,50 +439,47 @@ static void process_frame(AudioFFTDeNoiseContext *s, DeNoiseChannel *dnch,
             dnch->band_amt[j] += dnch->spread_function[i++] * dnch->band_excit[k];
         }
     }
+}
 
-    for (int i = 0; i < s->bin_count; i++)
-        dnch->amt[i] = dnch->band_amt[s->bin2band[i]];
-
-    if (dnch->amt[0] > dnch->abs_var[0]) {
-        dnch->gain[0] = 1.0;
-    } else if (dnch->amt[0] > dnch->min_abs_var[0]) {
-        double limit = sqrt(dnch->abs_var[0] / dnch->amt[0]);
-        dnch->gain[0] = limit_gain(dnch->gain[0], limit);
-    } else {
-        dnch->gain[0] = limit_gain(dnch->gain[0], s->max_gain);
-    }
-    if (dnch->amt[s->fft_length2] > dnch->abs_var[s->fft_length2]) {
-        dnch->gain[s->fft_length2] = 1.0;
-    } else if (dnch->amt[s->fft_length2] > dnch->min_abs_var[s->fft_length2]) {
-        double limit = sqrt(dnch->abs_var[s->fft_length2] / dnch->amt[s->fft_length2]);
-        dnch->gain[s->fft_length2] = limit_gain(dnch->gain[s->fft_length2], limit);
-    } else {
-        dnch->gain[s->fft_length2] = limit_gain(dnch->gain[s->fft_length2], s->max_gain);
-    }
-
-    for (int i = 1; i < s->fft_length2; i++) {
-        if (dnch->amt[i] > dnch->abs_var[i]) {
-            dnch->gain[i] = 1.0;
-        } else if (dnch->amt[i] > dnch->min_abs_var[i]) {
-            double limit = sqrt(dnch->abs_var[i] / dnch->amt[i]);
-            dnch->gain[i] = limit_gain(dnch->gain[i], limit);
+/**
+ * Limit the gain of the bins from start to end by the masking threshold
+ * and apply it to the spectrum.
+ */
+static void apply_gains(AudioFFTDeNoiseContext *s, DeNoiseChannel *dnch,
+                        AVComplexFloat *fft_data, int start, int end)
+{
+    const double *abs_var = dnch->abs_var;
+    const double *min_abs_var = dnch->min_abs_var;
+    const double *noisy_data = dnch->noisy_data;
+    double *clean_data = dnch->clean_data;
+    double *gain = dnch->gain;
+    double *amt = dnch->amt;
+
+    for (int i = start; i < end; i++)
+        amt[i] = dnch->band_amt[s->bin2band[i]];
+
+    for (int i = start; i < end; i++) {
+        if (amt[i] > abs_var[i]) {
+            gain[i] = 1.0;
+        } else if (amt[i] > min_abs_var[i]) {
+            double limit = sqrt(abs_var[i] / amt[i]);
+            gain[i] = limit_gain(gain[i], limit);
         } else {
-            dnch->gain[i] = limit_gain(dnch->gain[i], s->max_gain);
+            gain[i] = limit_gain(gain[i], s->max_gain);
         }
     }
 
-    gain = dnch->gain[0];
-    dnch->clean_data[0] = (gain * gain * dnch->noisy_data[0]);
-    fft_data[0].re *= gain;
-    gain = dnch->gain[s->fft_length2];
-    dnch->clean_data[s->fft_length2] = (gain * gain * dnch->noisy_data[s->fft_length2]);
-    fft_data[0].im *= gain;
-    for (int i = 1; i < s->fft_length2; i++) {
-        gain = dnch->gain[i];
-        dnch->clean_data[i] = (gain * gain * dnch->noisy_data[i]);
-        fft_data[i].re *= gain;
-        fft_data[i].im *= gain;
+    for (int i = start; i < end; i++)
+        clean_data[i] = gain[i] * gain[i] * noisy_data[i];
+
+    if (start == 0)
+        fft_data[0].re *= gain[0];
+    for (int i = FFMAX(start, 1); i < FFMIN(end, s->fft_length2); i++) {
+        fft_data[i].re *= gain[i];
+        fft_data[i].im *= gain[i];
     }
+    if (end > s->fft_length2)
+        fft_data[0].im *= gain[s->fft_length2];
 }
 
 static double freq2bark(double x)
@@ -578,7 +578,7 @@ static void read_custom_noise(AudioFFTDeNoiseContext *s, int ch)
     memcpy(dnch->band_noise, band_noise, sizeof(band_noise));
 }
 
-static void set_parameters(AudioFFTDeNoiseContext *s)
+static void update_gain_parameters(AudioFFTDeNoiseContext *s)
 {
     if (s->last_noise_floor != s->noise_floor)
         s->last_noise_floor = s->noise_floor;
@@ -599,6 +599,11 @@ static void set_parameters(AudioFFTDeNoiseContext *s)
     }
 
     s->gain_scale = 1.0 / (s->max_gain * s->max_gain);
+}
+
+static void set_parameters(AudioFFTDeNoiseContext *s)
+{
+    update_gain_parameters(s);
 
     for (int ch = 0; ch < s->channels; ch++) {
         DeNoiseChannel *dnch = &s->dnch[ch];
@@ -612,7 +617,8 @@ static int config_input(AVFilterLink *inlink)
     AVFilterContext *ctx = inlink->dst;
     AudioFFTDeNoiseContext *s = ctx->priv;
     double wscale, sar, sum, sdiv;
-    int i, j, k, m, n;
+    float scale = 1.f;
+    int i, j, k, m, n, ret;
 
     s->dnch = av_calloc(inlink->channels, sizeof(*s->dnch));
     if (!s->dnch)
@@ -728,8 +734,14 @@ static int config_input(AVFilterLink *inlink)
         dnch->rel_var = av_calloc(s->bin_count, sizeof(*dnch->rel_var));
         dnch->min_abs_var = av_calloc(s->bin_count, sizeof(*dnch->min_abs_var));
         dnch->fft_data = av_calloc(s->fft_length2 + 1, sizeof(*dnch->fft_data));
-        dnch->fft  = av_fft_init(av_log2(s->fft_length2), 0);
-        dnch->ifft = av_fft_init(av_log2(s->fft_length2), 1);
+        ret = av_tx_init(&dnch->fft, &dnch->tx_fn, AV_TX_FLOAT_FFT, 0,
+                         s->fft_length2, &scale, AV_TX_INPLACE);
+        if (ret < 0)
+            return ret;
+        ret = av_tx_init(&dnch->ifft, &dnch->itx_fn, AV_TX_FLOAT_FFT, 1,
+                         s->fft_length2, &scale, AV_TX_INPLACE);
+        if (ret < 0)
+            return ret;
         dnch->spread_function = av_calloc(s->number_of_bands * s->number_of_bands,
                                           sizeof(*dnch->spread_function));
 
@@ -746,9 +758,7 @@ static int config_input(AVFilterLink *inlink)
             !dnch->abs_var ||
             !dnch->rel_var ||
             !dnch->min_abs_var ||
-            !dnch->spread_function ||
-            !dnch->fft ||
-            !dnch->ifft)
+            !dnch->spread_function)
             return AVERROR(ENOMEM);
     }
 
@@ -855,7 +865,7 @@ static int config_input(AVFilterLink *inlink)
     return 0;
 }
 
-static void preprocess(FFTComplex *in, int len)
+static void preprocess(AVComplexFloat *in, int len)
 {
     double d1, d2, d3, d4, d5, d6, d7, d8, d9, d10;
     int n, i, k;
@@ -888,7 +898,7 @@ static void preprocess(FFTComplex *in, int len)
     in[0].im = d2 - in[0].im;
 }
 
-static void postprocess(FFTComplex *in, int len)
+static void postprocess(AVComplexFloat *in, int len)
 {
     double d1, d2, d3, d4, d5, d6, d7, d8, d9, d10;
     int n, i, k;
@@ -947,8 +957,7 @@ static void sample_noise_block(AudioFFTDeNoiseContext *s,
         dnch->fft_data[i].im = 0.0;
     }
 
-    av_fft_permute(dnch->fft, dnch->fft_data);
-    av_fft_calc(dnch->fft, dnch->fft_data);
+    dnch->tx_fn(dnch->fft, dnch->fft_data, dnch->fft_data, sizeof(float));
 
     preprocess(dnch->fft_data, s->fft_length);
 
@@ -1079,22 +1088,29 @@ static void set_noise_profile(AudioFFTDeNoiseContext *s,
         s->noise_floor = new_noise_floor;
 }
 
+enum FilterStage {
+    STAGE_FFT,
+    STAGE_GAINS,
+    STAGE_BANDS,
+    STAGE_APPLY,
+    STAGE_IFFT,
+    NB_STAGES
+};
+
 typedef struct ThreadData {
-    AVFrame *in;
+    AVFrame *in, *out;
+    int stage;
+    int bin_jobs;
 } ThreadData;
 
-static int filter_channel(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+static void run_stage(AudioFFTDeNoiseContext *s, ThreadData *td,
+                      int stage, int ch, int start, int end)
 {
-    AudioFFTDeNoiseContext *s = ctx->priv;
-    ThreadData *td = arg;
-    AVFrame *in = td->in;
-    const int start = (in->channels * jobnr) / nb_jobs;
-    const int end = (in->channels * (jobnr+1)) / nb_jobs;
+    DeNoiseChannel *dnch = &s->dnch[ch];
 
-    for (int ch = start; ch < end; ch++) {
-        DeNoiseChannel *dnch = &s->dnch[ch];
-        const float *src = (const float *)in->extended_data[ch];
-        double *dst = dnch->out_samples;
+    switch (stage) {
+    case STAGE_FFT: {
+        const float *src = (const float *)td->in->extended_data[ch];
 
         if (s->track_noise) {
             int i = s->block_count & 0x1FF;
@@ -1116,26 +1132,115 @@ static int filter_channel(AVFilterContext *ctx, void *arg, int jobnr, int nb_job
             dnch->fft_data[m].im = 0;
         }
 
-        av_fft_permute(dnch->fft, dnch->fft_data);
-        av_fft_calc(dnch->fft, dnch->fft_data);
+        dnch->tx_fn(dnch->fft, dnch->fft_data, dnch->fft_data, sizeof(float));
 
         preprocess(dnch->fft_data, s->fft_length);
-        process_frame(s, dnch, dnch->fft_data,
-                      dnch->prior,
-                      dnch->prior_band_excit,
-                      s->track_noise);
+        break;
+    }
+    case STAGE_GAINS:
+        compute_gains(s, dnch, dnch->fft_data, start, end);
+        break;
+    case STAGE_BANDS:
+        process_bands(s, dnch, dnch->prior_band_excit, s->track_noise);
+        break;
+    case STAGE_APPLY:
+        apply_gains(s, dnch, dnch->fft_data, start, end);
+        break;
+    case STAGE_IFFT: {
+        const float *orig = (const float *)td->in->extended_data[ch];
+        float *dst = (float *)td->out->extended_data[ch];
+        double *out_samples = dnch->out_samples;
+
         postprocess(dnch->fft_data, s->fft_length);
 
-        av_fft_permute(dnch->ifft, dnch->fft_data);
-        av_fft_calc(dnch->ifft, dnch->fft_data);
+        dnch->itx_fn(dnch->ifft, dnch->fft_data, dnch->fft_data, sizeof(float));
 
         for (int m = 0; m < s->window_length; m++)
-            dst[m] += s->window[m] * dnch->fft_data[m].re / (1LL << 24);
+            out_samples[m] += s->window[m] * dnch->fft_data[m].re / (1LL << 24);
+
+        switch (s->output_mode) {
+        case IN_MODE:
+            for (int m = 0; m < s->sample_advance; m++)
+                dst[m] = orig[m];
+            break;
+        case OUT_MODE:
+            for (int m = 0; m < s->sample_advance; m++)
+                dst[m] = out_samples[m];
+            break;
+        case NOISE_MODE:
+            for (int m = 0; m < s->sample_advance; m++)
+                dst[m] = orig[m] - out_samples[m];
+            break;
+        }
+        memmove(out_samples, out_samples + s->sample_advance, (s->window_length - s->sample_advance) * sizeof(*out_samples));
+        memset(out_samples + (s->window_length - s->sample_advance), 0, s->sample_advance * sizeof(*out_samples));
+        break;
+    }
+    }
+}
+
+/* Run all stages, jobs being split over channels only. */
+static int filter_channel(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    AudioFFTDeNoiseContext *s = ctx->priv;
+    ThreadData *td = arg;
+    const int start = (s->channels * jobnr) / nb_jobs;
+    const int end = (s->channels * (jobnr+1)) / nb_jobs;
+
+    for (int ch = start; ch < end; ch++) {
+        for (int stage = 0; stage < NB_STAGES; stage++)
+            run_stage(s, td, stage, ch, 0, s->bin_count);
+    }
+
+    return 0;
+}
+
+/* Run a single stage, jobs being split over channels and, for the per bin
+ * stages, over bin_jobs ranges of bins of each channel. */
+static int filter_stage(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    AudioFFTDeNoiseContext *s = ctx->priv;
+    ThreadData *td = arg;
+
+    if (td->stage == STAGE_GAINS || td->stage == STAGE_APPLY) {
+        const int ch = jobnr / td->bin_jobs;
+        const int slice = jobnr % td->bin_jobs;
+        const int start = (s->bin_count * slice) / td->bin_jobs;
+        const int end = (s->bin_count * (slice+1)) / td->bin_jobs;
+
+        run_stage(s, td, td->stage, ch, start, end);
+    } else {
+        run_stage(s, td, td->stage, jobnr, 0, s->bin_count);
     }
 
     return 0;
 }
 
+static int band_parameters_channel(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    AudioFFTDeNoiseContext *s = ctx->priv;
+    const int start = (s->channels * jobnr) / nb_jobs;
+    const int end = (s->channels * (jobnr+1)) / nb_jobs;
+
+    for (int ch = start; ch < end; ch++)
+        set_band_parameters(s, &s->dnch[ch]);
+
+    return 0;
+}
+
+static int sample_noise_channel(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    AudioFFTDeNoiseContext *s = ctx->priv;
+    ThreadData *td = arg;
+    const int start = (s->channels * jobnr) / nb_jobs;
+    const int end = (s->channels * (jobnr+1)) / nb_jobs;
+
+    for (int ch = start; ch < end; ch++)
+        sample_noise_block(s, &s->dnch[ch], td->in, ch);
+
+    return 0;
+}
+
 static void get_auto_noise_levels(AudioFFTDeNoiseContext *s,
                                   DeNoiseChannel *dnch,
                                   double *levels)
@@ -1160,6 +1265,7 @@ static int output_frame(AVFilterLink *inlink)
     AVFilterContext *ctx = inlink->dst;
     AVFilterLink *outlink = ctx->outputs[0];
     AudioFFTDeNoiseContext *s = ctx->priv;
+    const int nb_threads = ff_filter_get_nb_threads(ctx);
     AVFrame *out = NULL, *in = NULL;
     ThreadData td;
     int ret = 0;
@@ -1181,8 +1287,11 @@ static int output_frame(AVFilterLink *inlink)
             set_noise_profile(s, dnch, levels, 0);
         }
 
-        if (s->noise_floor != s->last_noise_floor)
-            set_parameters(s);
+        if (s->noise_floor != s->last_noise_floor) {
+            update_gain_parameters(s);
+            ctx->internal->execute(ctx, band_parameters_channel, NULL, NULL,
+                                   FFMIN(s->channels, nb_threads));
+        }
     }
 
     if (s->sample_noise_start) {
@@ -1195,13 +1304,10 @@ static int output_frame(AVFilterLink *inlink)
         s->sample_noise = 1;
     }
 
-    if (s->sample_noise) {
-        for (int ch = 0; ch < inlink->channels; ch++) {
-            DeNoiseChannel *dnch = &s->dnch[ch];
-
-            sample_noise_block(s, dnch, in, ch);
-        }
-    }
+    td.in = in;
+    if (s->sample_noise)
+        ctx->internal->execute(ctx, sample_noise_channel, &td, NULL,
+                               FFMIN(s->channels, nb_threads));
 
     if (s->sample_noise_end) {
         for (int ch = 0; ch < inlink->channels; ch++) {
@@ -1216,43 +1322,28 @@ static int output_frame(AVFilterLink *inlink)
         s->sample_noise_end = 0;
     }
 
-    s->block_count++;
-    td.in = in;
-    ctx->internal->execute(ctx, filter_channel, &td, NULL,
-                           FFMIN(outlink->channels, ff_filter_get_nb_threads(ctx)));
-
     out = ff_get_audio_buffer(outlink, s->sample_advance);
     if (!out) {
         ret = AVERROR(ENOMEM);
         goto end;
     }
 
-    for (int ch = 0; ch < inlink->channels; ch++) {
-        DeNoiseChannel *dnch = &s->dnch[ch];
-        double *src = dnch->out_samples;
-        float *orig = (float *)in->extended_data[ch];
-        float *dst = (float *)out->extended_data[ch];
+    s->block_count++;
+    td.out = out;
+    /* With fewer channels than threads, also split the per bin stages of
+     * each channel, keeping at least 64 bins per job. */
+    td.bin_jobs = FFMAX(FFMIN(nb_threads / s->channels, s->bin_count / 64), 1);
+    if (td.bin_jobs <= 1) {
+        ctx->internal->execute(ctx, filter_channel, &td, NULL,
+                               FFMIN(s->channels, nb_threads));
+    } else {
+        for (td.stage = 0; td.stage < NB_STAGES; td.stage++) {
+            int nb_jobs = s->channels;
 
-        switch (s->output_mode) {
-        case IN_MODE:
-            for (int m = 0; m < s->sample_advance; m++)
-                dst[m] = orig[m];
-            break;
-        case OUT_MODE:
-            for (int m = 0; m < s->sample_advance; m++)
-                dst[m] = src[m];
-            break;
-        case NOISE_MODE:
-            for (int m = 0; m < s->sample_advance; m++)
-                dst[m] = orig[m] - src[m];
-            break;
-        default:
-            av_frame_free(&out);
-            ret = AVERROR_BUG;
-            goto end;
+            if (td.stage == STAGE_GAINS || td.stage == STAGE_APPLY)
+                nb_jobs *= td.bin_jobs;
+            ctx->internal->execute(ctx, filter_stage, &td, NULL, nb_jobs);
         }
-        memmove(src, src + s->sample_advance, (s->window_length - s->sample_advance) * sizeof(*src));
-        memset(src + (s->window_length - s->sample_advance), 0, s->sample_advance * sizeof(*src));
     }
 
     av_audio_fifo_drain(s->fifo, s->sample_advance);
@@ -1331,10 +1422,8 @@ static av_cold void uninit(AVFilterContext *ctx)
             av_freep(&dnch->rel_var);
             av_freep(&dnch->min_abs_var);
             av_freep(&dnch->fft_data);
-            av_fft_end(dnch->fft);
-            dnch->fft = NULL;
-            av_fft_end(dnch->ifft);
-            dnch->ifft = NULL;
+            av_tx_uninit(&dnch->fft);
+            av_tx_uninit(&dnch->ifft);
         }
         av_freep(&s->dnch);
     }
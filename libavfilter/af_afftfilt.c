@@ -23,10 +23,11 @@
 #include "libavfilter/internal.h"
 #include "libavutil/common.h"
 #include "libavutil/opt.h"
-#include "libavcodec/avfft.h"
+#include "libavutil/tx.h"
 #include "libavutil/eval.h"
 #include "audio.h"
 #include "filters.h"
+#include "internal.h"
 #include "window_func.h"
 
 typedef struct AFFTFiltContext {
@@ -36,9 +37,10 @@ typedef struct AFFTFiltContext {
     int fft_size;
     int fft_bits;
 
-    FFTContext *fft, *ifft;
-    FFTComplex **fft_data;
-    FFTComplex **fft_temp;
+    AVTXContext **fft, **ifft;
+    av_tx_fn tx_fn, itx_fn;
+    AVComplexFloat **fft_data;
+    AVComplexFloat **fft_temp;
     int nb_exprs;
     int channels;
     int window_size;
@@ -133,12 +135,27 @@ static int config_input(AVFilterLink *inlink)
     s->channels = inlink->channels;
     s->pts  = AV_NOPTS_VALUE;
     s->fft_bits = av_log2(s->fft_size);
-    s->fft  = av_fft_init(s->fft_bits, 0);
-    s->ifft = av_fft_init(s->fft_bits, 1);
+    s->window_size = 1 << s->fft_bits;
+
+    s->fft  = av_calloc(inlink->channels, sizeof(*s->fft));
+    s->ifft = av_calloc(inlink->channels, sizeof(*s->ifft));
     if (!s->fft || !s->ifft)
         return AVERROR(ENOMEM);
 
-    s->window_size = 1 << s->fft_bits;
+    /* one transform context per channel, so channels can run in parallel */
+    for (ch = 0; ch < inlink->channels; ch++) {
+        float scale = 1.f;
+
+        ret = av_tx_init(&s->fft[ch], &s->tx_fn, AV_TX_FLOAT_FFT, 0, s->window_size,
+                         &scale, AV_TX_INPLACE);
+        if (ret < 0)
+            return ret;
+
+        ret = av_tx_init(&s->ifft[ch], &s->itx_fn, AV_TX_FLOAT_FFT, 1, s->window_size,
+                         &scale, AV_TX_INPLACE);
+        if (ret < 0)
+            return ret;
+    }
 
     s->fft_data = av_calloc(inlink->channels, sizeof(*s->fft_data));
     if (!s->fft_data)
@@ -231,16 +248,81 @@ fail:
     return ret;
 }
 
+static int tx_channel(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    AFFTFiltContext *s = ctx->priv;
+    const int channels = s->channels;
+    const int start = (channels * jobnr) / nb_jobs;
+    const int end = (channels * (jobnr+1)) / nb_jobs;
+
+    for (int ch = start; ch < end; ch++) {
+        AVComplexFloat *fft_data = s->fft_data[ch];
+
+        s->tx_fn(s->fft[ch], fft_data, fft_data, sizeof(float));
+    }
+
+    return 0;
+}
+
+static int filter_channel(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    AFFTFiltContext *s = ctx->priv;
+    const int window_size = s->window_size;
+    const float f = 1. / (s->window_size / 2);
+    const int channels = s->channels;
+    const int start = (channels * jobnr) / nb_jobs;
+    const int end = (channels * (jobnr+1)) / nb_jobs;
+    double values[VAR_VARS_NB];
+
+    memcpy(values, arg, sizeof(values));
+
+    for (int ch = start; ch < end; ch++) {
+        AVComplexFloat *fft_data = s->fft_data[ch];
+        AVComplexFloat *fft_temp = s->fft_temp[ch];
+        float *buf = (float *)s->buffer->extended_data[ch];
+        int n, x;
+
+        values[VAR_CHANNEL] = ch;
+
+        for (n = 0; n <= window_size / 2; n++) {
+            float fr, fi;
+
+            values[VAR_BIN] = n;
+            values[VAR_REAL] = fft_data[n].re;
+            values[VAR_IMAG] = fft_data[n].im;
+
+            fr = av_expr_eval(s->real[ch], values, s);
+            fi = av_expr_eval(s->imag[ch], values, s);
+
+            fft_temp[n].re = fr;
+            fft_temp[n].im = fi;
+        }
+
+        for (n = window_size / 2 + 1, x = window_size / 2 - 1; n < window_size; n++, x--) {
+            fft_temp[n].re =  fft_temp[x].re;
+            fft_temp[n].im = -fft_temp[x].im;
+        }
+
+        s->itx_fn(s->ifft[ch], fft_temp, fft_temp, sizeof(float));
+
+        for (int i = 0; i < window_size; i++) {
+            buf[i] += s->fft_temp[ch][i].re * f;
+        }
+    }
+
+    return 0;
+}
+
 static int filter_frame(AVFilterLink *inlink)
 {
     AVFilterContext *ctx = inlink->dst;
     AVFilterLink *outlink = ctx->outputs[0];
     AFFTFiltContext *s = ctx->priv;
     const int window_size = s->window_size;
-    const float f = 1. / (s->window_size / 2);
+    const int nb_jobs = FFMIN(inlink->channels, ff_filter_get_nb_threads(ctx));
     double values[VAR_VARS_NB];
     AVFrame *out, *in = NULL;
-    int ch, n, ret, i;
+    int ch, n, ret;
 
     if (!in) {
         in = ff_get_audio_buffer(outlink, window_size);
@@ -254,7 +336,7 @@ static int filter_frame(AVFilterLink *inlink)
 
     for (ch = 0; ch < inlink->channels; ch++) {
         const float *src = (float *)in->extended_data[ch];
-        FFTComplex *fft_data = s->fft_data[ch];
+        AVComplexFloat *fft_data = s->fft_data[ch];
 
         for (n = 0; n < in->nb_samples; n++) {
             fft_data[n].re = src[n] * s->window_func_lut[n];
@@ -272,46 +354,10 @@ static int filter_frame(AVFilterLink *inlink)
     values[VAR_NBBINS]      = window_size / 2;
     values[VAR_CHANNELS]    = inlink->channels;
 
-    for (ch = 0; ch < inlink->channels; ch++) {
-        FFTComplex *fft_data = s->fft_data[ch];
-
-        av_fft_permute(s->fft, fft_data);
-        av_fft_calc(s->fft, fft_data);
-    }
-
-    for (ch = 0; ch < inlink->channels; ch++) {
-        FFTComplex *fft_data = s->fft_data[ch];
-        FFTComplex *fft_temp = s->fft_temp[ch];
-        float *buf = (float *)s->buffer->extended_data[ch];
-        int x;
-        values[VAR_CHANNEL] = ch;
-
-        for (n = 0; n <= window_size / 2; n++) {
-            float fr, fi;
-
-            values[VAR_BIN] = n;
-            values[VAR_REAL] = fft_data[n].re;
-            values[VAR_IMAG] = fft_data[n].im;
-
-            fr = av_expr_eval(s->real[ch], values, s);
-            fi = av_expr_eval(s->imag[ch], values, s);
-
-            fft_temp[n].re = fr;
-            fft_temp[n].im = fi;
-        }
-
-        for (n = window_size / 2 + 1, x = window_size / 2 - 1; n < window_size; n++, x--) {
-            fft_temp[n].re =  fft_temp[x].re;
-            fft_temp[n].im = -fft_temp[x].im;
-        }
-
-        av_fft_permute(s->ifft, fft_temp);
-        av_fft_calc(s->ifft, fft_temp);
-
-        for (i = 0; i < window_size; i++) {
-            buf[i] += s->fft_temp[ch][i].re * f;
-        }
-    }
+    /* The expressions can refer to the bins of any channel, so all the
+     * forward transforms have to be done before any of them is evaluated. */
+    ctx->internal->execute(ctx, tx_channel, NULL, NULL, nb_jobs);
+    ctx->internal->execute(ctx, filter_channel, values, NULL, nb_jobs);
 
     out = ff_get_audio_buffer(outlink, s->hop_size);
     if (!out) {
@@ -434,15 +480,18 @@ static av_cold void uninit(AVFilterContext *ctx)
     AFFTFiltContext *s = ctx->priv;
     int i;
 
-    av_fft_end(s->fft);
-    av_fft_end(s->ifft);
-
     for (i = 0; i < s->channels; i++) {
+        if (s->fft)
+            av_tx_uninit(&s->fft[i]);
+        if (s->ifft)
+            av_tx_uninit(&s->ifft[i]);
         if (s->fft_data)
             av_freep(&s->fft_data[i]);
         if (s->fft_temp)
             av_freep(&s->fft_temp[i]);
     }
+    av_freep(&s->fft);
+    av_freep(&s->ifft);
     av_freep(&s->fft_data);
     av_freep(&s->fft_temp);
 
@@ -486,4 +535,5 @@ AVFilter ff_af_afftfilt = {
     .activate        = activate,
     .query_formats   = query_formats,
     .uninit          = uninit,
+    .flags           = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -29,7 +29,6 @@
  */
 
 #include "libavutil/attributes.h"
-#include "libavutil/audio_fifo.h"
 #include "libavutil/avassert.h"
 #include "libavutil/avstring.h"
 #include "libavutil/channel_layout.h"
@@ -47,114 +46,12 @@
 #include "internal.h"
 
 #define INPUT_ON       1    /**< input is active */
-#define INPUT_EOF      2    /**< input has reached EOF (may still be active) */
 
 #define DURATION_LONGEST  0
 #define DURATION_SHORTEST 1
 #define DURATION_FIRST    2
 
 
-typedef struct FrameInfo {
-    int nb_samples;
-    int64_t pts;
-    struct FrameInfo *next;
-} FrameInfo;
-
-/**
- * Linked list used to store timestamps and frame sizes of all frames in the
- * FIFO for the first input.
- *
- * This is needed to keep timestamps synchronized for the case where multiple
- * input frames are pushed to the filter for processing before a frame is
- * requested by the output link.
- */
-typedef struct FrameList {
-    int nb_frames;
-    int nb_samples;
-    FrameInfo *list;
-    FrameInfo *end;
-} FrameList;
-
-static void frame_list_clear(FrameList *frame_list)
-{
-    if (frame_list) {
-        while (frame_list->list) {
-            FrameInfo *info = frame_list->list;
-            frame_list->list = info->next;
-            av_free(info);
-        }
-        frame_list->nb_frames  = 0;
-        frame_list->nb_samples = 0;
-        frame_list->end        = NULL;
-    }
-}
-
-static int frame_list_next_frame_size(FrameList *frame_list)
-{
-    if (!frame_list->list)
-        return 0;
-    return frame_list->list->nb_samples;
-}
-
-static int64_t frame_list_next_pts(FrameList *frame_list)
-{
-    if (!frame_list->list)
-        return AV_NOPTS_VALUE;
-    return frame_list->list->pts;
-}
-
-static void frame_list_remove_samples(FrameList *frame_list, int nb_samples)
-{
-    if (nb_samples >= frame_list->nb_samples) {
-        frame_list_clear(frame_list);
-    } else {
-        int samples = nb_samples;
-        while (samples > 0) {
-            FrameInfo *info = frame_list->list;
-            av_assert0(info);
-            if (info->nb_samples <= samples) {
-                samples -= info->nb_samples;
-                frame_list->list = info->next;
-                if (!frame_list->list)
-                    frame_list->end = NULL;
-                frame_list->nb_frames--;
-                frame_list->nb_samples -= info->nb_samples;
-                av_free(info);
-            } else {
-                info->nb_samples       -= samples;
-                info->pts              += samples;
-                frame_list->nb_samples -= samples;
-                samples = 0;
-            }
-        }
-    }
-}
-
-static int frame_list_add_frame(FrameList *frame_list, int nb_samples, int64_t pts)
-{
-    FrameInfo *info = av_malloc(sizeof(*info));
-    if (!info)
-        return AVERROR(ENOMEM);
-    info->nb_samples = nb_samples;
-    info->pts        = pts;
-    info->next       = NULL;
-
-    if (!frame_list->list) {
-        frame_list->list = info;
-        frame_list->end  = info;
-    } else {
-        av_assert0(frame_list->end);
-        frame_list->end->next = info;
-        frame_list->end       = info;
-    }
-    frame_list->nb_frames++;
-    frame_list->nb_samples += nb_samples;
-
-    return 0;
-}
-
-/* FIXME: use directly links fifo */
-
 typedef struct MixContext {
     const AVClass *class;       /**< class for AVOptions */
     AVFloatDSPContext *fdsp;
@@ -169,14 +66,13 @@ typedef struct MixContext {
     int nb_channels;            /**< number of channels */
     int sample_rate;            /**< sample rate */
     int planar;
-    AVAudioFifo **fifos;        /**< audio fifo for each input */
+    AVFrame **in_bufs;          /**< frames being mixed, one for each input */
     uint8_t *input_state;       /**< current state of each input */
     float *input_scale;         /**< mixing scale factor for each input */
     float *weights;             /**< custom weights for every input */
     float weight_sum;           /**< sum of custom weights for every input */
     float *scale_norm;          /**< normalization factor for every input */
     int64_t next_pts;           /**< calculated pts for next output frame */
-    FrameList *frame_list;      /**< list of frame info for the first input */
 } MixContext;
 
 #define OFFSET(x) offsetof(MixContext, x)
@@ -252,22 +148,12 @@ static int config_output(AVFilterLink *outlink)
     s->sample_rate     = outlink->sample_rate;
     outlink->time_base = (AVRational){ 1, outlink->sample_rate };
     s->next_pts        = AV_NOPTS_VALUE;
+    s->nb_channels     = outlink->channels;
 
-    s->frame_list = av_mallocz(sizeof(*s->frame_list));
-    if (!s->frame_list)
+    s->in_bufs = av_mallocz_array(s->nb_inputs, sizeof(*s->in_bufs));
+    if (!s->in_bufs)
         return AVERROR(ENOMEM);
 
-    s->fifos = av_mallocz_array(s->nb_inputs, sizeof(*s->fifos));
-    if (!s->fifos)
-        return AVERROR(ENOMEM);
-
-    s->nb_channels = outlink->channels;
-    for (i = 0; i < s->nb_inputs; i++) {
-        s->fifos[i] = av_audio_fifo_alloc(outlink->format, s->nb_channels, 1024);
-        if (!s->fifos[i])
-            return AVERROR(ENOMEM);
-    }
-
     s->input_state = av_malloc(s->nb_inputs);
     if (!s->input_state)
         return AVERROR(ENOMEM);
@@ -291,24 +177,107 @@ static int config_output(AVFilterLink *outlink)
     return 0;
 }
 
+typedef struct ThreadData {
+    AVFrame *out;
+    int nb_samples;
+} ThreadData;
+
+#define MIX_PLANE(name, type, dsp_fn)                                               \
+static void mix_plane_##name(MixContext *s, type *dst, const AVFrame *in, int p,   \
+                             int start, int end, int plane_size, float scale)     \
+{                                                                                  \
+    const type *src = (const type *)in->extended_data[p];                          \
+                                                                                   \
+    /* The DSP functions need aligned pointers and padded lengths, which is  */    \
+    /* not guaranteed for frames which were partially consumed from a link.  */    \
+    if (!((uintptr_t)src & 31) &&                                                  \
+        FFALIGN(plane_size, 16) * sizeof(type) <= in->linesize[0]) {               \
+        s->fdsp->dsp_fn(dst + start, src + start, scale,                           \
+                        FFALIGN(end - start, 16));                                 \
+    } else {                                                                       \
+        for (int n = start; n < end; n++)                                          \
+            dst[n] += src[n] * scale;                                              \
+    }                                                                              \
+}
+
+MIX_PLANE(flt, float,  vector_fmac_scalar)
+MIX_PLANE(dbl, double, vector_dmac_scalar)
+
+static int mix_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    MixContext *s = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *out = td->out;
+    const int planes     = s->planar ? s->nb_channels : 1;
+    const int plane_size = td->nb_samples * (s->planar ? 1 : s->nb_channels);
+    int start, end, p_start, p_end;
+
+    if (s->planar) {
+        /* split the channels between the jobs */
+        p_start = (planes *  jobnr   ) / nb_jobs;
+        p_end   = (planes * (jobnr+1)) / nb_jobs;
+        start   = 0;
+        end     = plane_size;
+    } else {
+        /* split the interleaved samples in blocks of 16 */
+        const int nb_blocks = (plane_size + 15) >> 4;
+
+        p_start = 0;
+        p_end   = 1;
+        start   = 16 * ((nb_blocks *  jobnr   ) / nb_jobs);
+        end     = FFMIN(16 * ((nb_blocks * (jobnr+1)) / nb_jobs), plane_size);
+    }
+
+    for (int i = 0; i < s->nb_inputs; i++) {
+        const AVFrame *in = s->in_bufs[i];
+
+        if (!(s->input_state[i] & INPUT_ON) || !in)
+            continue;
+
+        for (int p = p_start; p < p_end; p++) {
+            if (out->format == AV_SAMPLE_FMT_FLT ||
+                out->format == AV_SAMPLE_FMT_FLTP) {
+                mix_plane_flt(s, (float *)out->extended_data[p], in, p,
+                              start, end, plane_size, s->input_scale[i]);
+            } else {
+                mix_plane_dbl(s, (double *)out->extended_data[p], in, p,
+                              start, end, plane_size, s->input_scale[i]);
+            }
+        }
+    }
+
+    return 0;
+}
+
 /**
- * Read samples from the input FIFOs, mix, and write to the output link.
+ * Take samples from the input links, mix, and write to the output link.
+ *
+ * @return 1 if a frame was output, 0 if more input is needed or a negative
+ *         error code
  */
 static int output_frame(AVFilterLink *outlink)
 {
     AVFilterContext *ctx = outlink->src;
     MixContext      *s = ctx->priv;
-    AVFrame *out_buf, *in_buf;
-    int nb_samples, ns, i;
+    AVFrame *out_buf;
+    ThreadData td;
+    int nb_samples, ns, i, ret, nb_jobs;
 
     if (s->input_state[0] & INPUT_ON) {
+        AVFilterLink *inlink = ctx->inputs[0];
+        AVFrame *frame;
+
+        if (!ff_inlink_queued_frames(inlink))
+            return 0;
+
         /* first input live: use the corresponding frame size */
-        nb_samples = frame_list_next_frame_size(s->frame_list);
+        frame      = ff_inlink_peek_frame(inlink, 0);
+        nb_samples = frame->nb_samples;
         for (i = 1; i < s->nb_inputs; i++) {
             if (s->input_state[i] & INPUT_ON) {
-                ns = av_audio_fifo_size(s->fifos[i]);
+                ns = ff_inlink_queued_samples(ctx->inputs[i]);
                 if (ns < nb_samples) {
-                    if (!(s->input_state[i] & INPUT_EOF))
+                    if (!ff_inlink_check_available_samples(ctx->inputs[i], nb_samples))
                         /* unclosed input with not enough samples */
                         return 0;
                     /* closed input to drain */
@@ -317,13 +286,14 @@ static int output_frame(AVFilterLink *outlink)
             }
         }
 
-        s->next_pts = frame_list_next_pts(s->frame_list);
+        s->next_pts = frame->pts == AV_NOPTS_VALUE ? AV_NOPTS_VALUE :
+                      av_rescale_q(frame->pts, inlink->time_base, outlink->time_base);
     } else {
         /* first input closed: use the available samples */
         nb_samples = INT_MAX;
         for (i = 1; i < s->nb_inputs; i++) {
             if (s->input_state[i] & INPUT_ON) {
-                ns = av_audio_fifo_size(s->fifos[i]);
+                ns = ff_inlink_queued_samples(ctx->inputs[i]);
                 nb_samples = FFMIN(nb_samples, ns);
             }
         }
@@ -333,78 +303,51 @@ static int output_frame(AVFilterLink *outlink)
         }
     }
 
-    frame_list_remove_samples(s->frame_list, nb_samples);
-
     calculate_scales(s, nb_samples);
 
     if (nb_samples == 0)
         return 0;
 
-    out_buf = ff_get_audio_buffer(outlink, nb_samples);
-    if (!out_buf)
-        return AVERROR(ENOMEM);
-
-    in_buf = ff_get_audio_buffer(outlink, nb_samples);
-    if (!in_buf) {
-        av_frame_free(&out_buf);
-        return AVERROR(ENOMEM);
-    }
-
+    /* Take exactly nb_samples from every live input; whole frames are
+     * passed through without copying. */
     for (i = 0; i < s->nb_inputs; i++) {
         if (s->input_state[i] & INPUT_ON) {
-            int planes, plane_size, p;
+            ret = ff_inlink_consume_samples(ctx->inputs[i], nb_samples, nb_samples,
+                                            &s->in_bufs[i]);
+            if (ret < 0)
+                goto fail;
+            av_assert0(ret > 0);
+        }
+    }
 
-            av_audio_fifo_read(s->fifos[i], (void **)in_buf->extended_data,
-                               nb_samples);
+    out_buf = ff_get_audio_buffer(outlink, nb_samples);
+    if (!out_buf) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
 
-            planes     = s->planar ? s->nb_channels : 1;
-            plane_size = nb_samples * (s->planar ? 1 : s->nb_channels);
-            plane_size = FFALIGN(plane_size, 16);
+    td.out        = out_buf;
+    td.nb_samples = nb_samples;
+    if (s->planar)
+        nb_jobs = s->nb_channels;
+    else
+        nb_jobs = (nb_samples * s->nb_channels + 15) >> 4;
+    nb_jobs = FFMIN(nb_jobs, ff_filter_get_nb_threads(ctx));
+    ctx->internal->execute(ctx, mix_slice, &td, NULL, nb_jobs);
 
-            if (out_buf->format == AV_SAMPLE_FMT_FLT ||
-                out_buf->format == AV_SAMPLE_FMT_FLTP) {
-                for (p = 0; p < planes; p++) {
-                    s->fdsp->vector_fmac_scalar((float *)out_buf->extended_data[p],
-                                                (float *) in_buf->extended_data[p],
-                                                s->input_scale[i], plane_size);
-                }
-            } else {
-                for (p = 0; p < planes; p++) {
-                    s->fdsp->vector_dmac_scalar((double *)out_buf->extended_data[p],
-                                                (double *) in_buf->extended_data[p],
-                                                s->input_scale[i], plane_size);
-                }
-            }
-        }
-    }
-    av_frame_free(&in_buf);
+    for (i = 0; i < s->nb_inputs; i++)
+        av_frame_free(&s->in_bufs[i]);
 
     out_buf->pts = s->next_pts;
     if (s->next_pts != AV_NOPTS_VALUE)
         s->next_pts += nb_samples;
 
-    return ff_filter_frame(outlink, out_buf);
-}
-
-/**
- * Requests a frame, if needed, from each input link other than the first.
- */
-static int request_samples(AVFilterContext *ctx, int min_samples)
-{
-    MixContext *s = ctx->priv;
-    int i;
-
-    av_assert0(s->nb_inputs > 1);
-
-    for (i = 1; i < s->nb_inputs; i++) {
-        if (!(s->input_state[i] & INPUT_ON) ||
-             (s->input_state[i] & INPUT_EOF))
-            continue;
-        if (av_audio_fifo_size(s->fifos[i]) >= min_samples)
-            continue;
-        ff_inlink_request_frame(ctx->inputs[i]);
-    }
-    return output_frame(ctx->outputs[0]);
+    ret = ff_filter_frame(outlink, out_buf);
+    return ret < 0 ? ret : 1;
+fail:
+    for (i = 0; i < s->nb_inputs; i++)
+        av_frame_free(&s->in_bufs[i]);
+    return ret;
 }
 
 /**
@@ -432,58 +375,31 @@ static int activate(AVFilterContext *ctx)
 {
     AVFilterLink *outlink = ctx->outputs[0];
     MixContext *s = ctx->priv;
-    AVFrame *buf = NULL;
     int i, ret;
 
     FF_FILTER_FORWARD_STATUS_BACK_ALL(outlink, ctx);
 
-    for (i = 0; i < s->nb_inputs; i++) {
-        AVFilterLink *inlink = ctx->inputs[i];
-
-        if ((ret = ff_inlink_consume_frame(ctx->inputs[i], &buf)) > 0) {
-            if (i == 0) {
-                int64_t pts = av_rescale_q(buf->pts, inlink->time_base,
-                                           outlink->time_base);
-                ret = frame_list_add_frame(s->frame_list, buf->nb_samples, pts);
-                if (ret < 0) {
-                    av_frame_free(&buf);
-                    return ret;
-                }
-            }
-
-            ret = av_audio_fifo_write(s->fifos[i], (void **)buf->extended_data,
-                                      buf->nb_samples);
-            if (ret < 0) {
-                av_frame_free(&buf);
-                return ret;
-            }
-
-            av_frame_free(&buf);
-
-            ret = output_frame(outlink);
-            if (ret < 0)
-                return ret;
-        }
-    }
+    /* mix everything that is already queued on the inputs */
+    do {
+        ret = output_frame(outlink);
+        if (ret < 0)
+            return ret;
+    } while (ret > 0);
 
     for (i = 0; i < s->nb_inputs; i++) {
         int64_t pts;
         int status;
 
+        if (!(s->input_state[i] & INPUT_ON))
+            continue;
         if (ff_inlink_acknowledge_status(ctx->inputs[i], &status, &pts)) {
             if (status == AVERROR_EOF) {
-                if (i == 0) {
-                    s->input_state[i] = 0;
-                    if (s->nb_inputs == 1) {
-                        ff_outlink_set_status(outlink, status, pts);
-                        return 0;
-                    }
-                } else {
-                    s->input_state[i] |= INPUT_EOF;
-                    if (av_audio_fifo_size(s->fifos[i]) == 0) {
-                        s->input_state[i] = 0;
-                    }
+                s->input_state[i] = 0;
+                if (i == 0 && s->nb_inputs == 1) {
+                    ff_outlink_set_status(outlink, status, pts);
+                    return 0;
                 }
+                ff_filter_set_ready(ctx, 10);
             }
         }
     }
@@ -494,20 +410,23 @@ static int activate(AVFilterContext *ctx)
     }
 
     if (ff_outlink_frame_wanted(outlink)) {
-        int wanted_samples;
-
-        if (!(s->input_state[0] & INPUT_ON))
-            return request_samples(ctx, 1);
+        int wanted_samples = 1;
 
-        if (s->frame_list->nb_frames == 0) {
-            ff_inlink_request_frame(ctx->inputs[0]);
-            return 0;
+        if (s->input_state[0] & INPUT_ON) {
+            if (!ff_inlink_queued_frames(ctx->inputs[0])) {
+                ff_inlink_request_frame(ctx->inputs[0]);
+                return 0;
+            }
+            wanted_samples = ff_inlink_peek_frame(ctx->inputs[0], 0)->nb_samples;
         }
-        av_assert0(s->frame_list->nb_frames > 0);
 
-        wanted_samples = frame_list_next_frame_size(s->frame_list);
-
-        return request_samples(ctx, wanted_samples);
+        for (i = 1; i < s->nb_inputs; i++) {
+            if (!(s->input_state[i] & INPUT_ON))
+                continue;
+            if (ff_inlink_check_available_samples(ctx->inputs[i], wanted_samples))
+                continue;
+            ff_inlink_request_frame(ctx->inputs[i]);
+        }
     }
 
     return 0;
@@ -577,13 +496,11 @@ static av_cold void uninit(AVFilterContext *ctx)
     int i;
     MixContext *s = ctx->priv;
 
-    if (s->fifos) {
+    if (s->in_bufs) {
         for (i = 0; i < s->nb_inputs; i++)
-            av_audio_fifo_free(s->fifos[i]);
-        av_freep(&s->fifos);
+            av_frame_free(&s->in_bufs[i]);
+        av_freep(&s->in_bufs);
     }
-    frame_list_clear(s->frame_list);
-    av_freep(&s->frame_list);
     av_freep(&s->input_state);
     av_freep(&s->input_scale);
     av_freep(&s->scale_norm);
@@ -649,5 +566,6 @@ AVFilter ff_af_amix = {
     .inputs         = NULL,
     .outputs        = avfilter_af_amix_outputs,
     .process_command = process_command,
-    .flags          = AVFILTER_FLAG_DYNAMIC_INPUTS,
+    .flags          = AVFILTER_FLAG_DYNAMIC_INPUTS |
+                      AVFILTER_FLAG_SLICE_THREADS,
 };
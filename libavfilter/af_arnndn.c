@@ -291,7 +291,7 @@ static int rnnoise_model_from_file(FILE *f, RNNModel **rnn)
     ret->name ## _size = name->nb_neurons; \
     INPUT_ACTIVATION(name->activation); \
     NEW_LINE(); \
-    INPUT_ARRAY(name->input_weights, name->nb_inputs * name->nb_neurons); \
+    INPUT_ARRAY3(name->input_weights, name->nb_inputs, name->nb_neurons, 1); \
     NEW_LINE(); \
     INPUT_ARRAY(name->bias, name->nb_neurons); \
     NEW_LINE(); \
@@ -1262,16 +1262,16 @@ static inline float sigmoid_approx(float x)
     return .5f + .5f*tansig_approx(.5f*x);
 }
 
-static void compute_dense(const DenseLayer *layer, float *output, const float *input)
+static void compute_dense(AudioRNNContext *s, const DenseLayer *layer, float *output, const float *input)
 {
-    const int N = layer->nb_neurons, M = layer->nb_inputs, stride = N;
+    const int N = layer->nb_neurons, M = layer->nb_inputs;
+    const int AM = FFALIGN(M, 4);
 
     for (int i = 0; i < N; i++) {
         /* Compute update gate. */
         float sum = layer->bias[i];
 
-        for (int j = 0; j < M; j++)
-            sum += layer->input_weights[j * stride + i] * input[j];
+        sum += s->fdsp->scalarproduct_float(layer->input_weights + i * AM, input, AM);
 
         output[i] = WEIGHTS_SCALE * sum;
     }
@@ -1295,6 +1295,7 @@ static void compute_gru(AudioRNNContext *s, const GRULayer *gru, float *state, c
     LOCAL_ALIGNED_32(float, z, [MAX_NEURONS]);
     LOCAL_ALIGNED_32(float, r, [MAX_NEURONS]);
     LOCAL_ALIGNED_32(float, h, [MAX_NEURONS]);
+    LOCAL_ALIGNED_32(float, rs, [MAX_NEURONS]);
     const int M = gru->nb_inputs;
     const int N = gru->nb_neurons;
     const int AN = FFALIGN(N, 4);
@@ -1319,13 +1320,15 @@ static void compute_gru(AudioRNNContext *s, const GRULayer *gru, float *state, c
         r[i] = sigmoid_approx(WEIGHTS_SCALE * sum);
     }
 
+    s->fdsp->vector_fmul(rs, state, r, FFALIGN(N, 16));
+    memset(rs + N, 0, (AN - N) * sizeof(*rs));
+
     for (int i = 0; i < N; i++) {
         /* Compute output. */
         float sum = gru->bias[2 * N + i];
 
         sum += s->fdsp->scalarproduct_float(gru->input_weights + 2 * AM + i * istride, input, AM);
-        for (int j = 0; j < N; j++)
-            sum += gru->recurrent_weights[2 * AN + i * stride + j] * state[j] * r[j];
+        sum += s->fdsp->scalarproduct_float(gru->recurrent_weights + 2 * AN + i * stride, rs, AN);
 
         if (gru->activation == ACTIVATION_SIGMOID)
             sum = sigmoid_approx(WEIGHTS_SCALE * sum);
@@ -1349,9 +1352,14 @@ static void compute_rnn(AudioRNNContext *s, RNNState *rnn, float *gains, float *
     LOCAL_ALIGNED_32(float, noise_input,   [MAX_NEURONS * 3]);
     LOCAL_ALIGNED_32(float, denoise_input, [MAX_NEURONS * 3]);
 
-    compute_dense(rnn->model->input_dense, dense_out, input);
+    /* the layers read their inputs in blocks of 4, keep the padding zeroed */
+    memset(dense_out, 0, sizeof(float) * MAX_NEURONS);
+    memset(noise_input, 0, sizeof(float) * MAX_NEURONS * 3);
+    memset(denoise_input, 0, sizeof(float) * MAX_NEURONS * 3);
+
+    compute_dense(s, rnn->model->input_dense, dense_out, input);
     compute_gru(s, rnn->model->vad_gru, rnn->vad_gru_state, dense_out);
-    compute_dense(rnn->model->vad_output, vad, rnn->vad_gru_state);
+    compute_dense(s, rnn->model->vad_output, vad, rnn->vad_gru_state);
 
     memcpy(noise_input, dense_out, rnn->model->input_dense_size * sizeof(float));
     memcpy(noise_input + rnn->model->input_dense_size,
@@ -1368,7 +1376,7 @@ static void compute_rnn(AudioRNNContext *s, RNNState *rnn, float *gains, float *
            input, INPUT_SIZE * sizeof(float));
 
     compute_gru(s, rnn->model->denoise_gru, rnn->denoise_gru_state, denoise_input);
-    compute_dense(rnn->model->denoise_output, gains, rnn->denoise_gru_state);
+    compute_dense(s, rnn->model->denoise_output, gains, rnn->denoise_gru_state);
 }
 
 static float rnnoise_channel(AudioRNNContext *s, DenoiseState *st, float *out, const float *in,
@@ -1379,7 +1387,7 @@ static float rnnoise_channel(AudioRNNContext *s, DenoiseState *st, float *out, c
     float x[FRAME_SIZE];
     float Ex[NB_BANDS], Ep[NB_BANDS];
     LOCAL_ALIGNED_32(float, Exp, [NB_BANDS]);
-    float features[NB_FEATURES];
+    LOCAL_ALIGNED_32(float, features, [FFALIGN(NB_FEATURES, 4)]);
     float g[NB_BANDS];
     float gf[FREQ_SIZE];
     float vad_prob = 0;
@@ -1388,6 +1396,7 @@ static float rnnoise_channel(AudioRNNContext *s, DenoiseState *st, float *out, c
     static const float b_hp[2] = {-2, 1};
     int silence;
 
+    memset(features + NB_FEATURES, 0, (FFALIGN(NB_FEATURES, 4) - NB_FEATURES) * sizeof(*features));
     biquad(x, st->mem_hp_x, in, b_hp, a_hp, FRAME_SIZE);
     silence = compute_frame_features(s, st, X, P, Ex, Ep, Exp, features, x);
 
@@ -119,6 +119,9 @@ typedef struct ATempoContext {
     // fragment window size, power-of-two integer:
     int window;
 
+    // requested fragment window duration, 0 selects 1/24 of a second:
+    int64_t window_duration;
+
     // Hann window coefficients, for feathering
     // (blending) the overlapping fragment region:
     float *hann;
@@ -163,6 +166,10 @@ static const AVOption atempo_options[] = {
       YAE_ATEMPO_MIN,
       YAE_ATEMPO_MAX,
       AV_OPT_FLAG_AUDIO_PARAM | AV_OPT_FLAG_FILTERING_PARAM | AV_OPT_FLAG_RUNTIME_PARAM },
+    { "window", "set fragment window duration",
+      OFFSET(window_duration), AV_OPT_TYPE_DURATION, { .i64 = 0 },
+      0, 100000,
+      AV_OPT_FLAG_AUDIO_PARAM | AV_OPT_FLAG_FILTERING_PARAM },
     { NULL }
 };
 
@@ -273,7 +280,11 @@ static int yae_reset(ATempoContext *atempo,
     atempo->stride   = sample_size * channels;
 
     // pick a segment window size:
-    atempo->window = sample_rate / 24;
+    if (atempo->window_duration)
+        atempo->window = FFMAX(av_rescale(sample_rate, atempo->window_duration,
+                                          AV_TIME_BASE), 32);
+    else
+        atempo->window = sample_rate / 24;
 
     // adjust window size to be a power-of-two integer:
     nlevels = av_log2(atempo->window);
@@ -441,7 +452,7 @@ static int yae_load_data(ATempoContext *atempo,
         int src_samples = (src_end - src) / atempo->stride;
 
         // load data piece-wise, in order to avoid complicating the logic:
-        int nsamples = FFMIN(read_size, src_samples);
+        int nsamples = FFMIN(stop_here - atempo->position[0], src_samples);
         int na;
         int nb;
 
@@ -731,25 +742,37 @@ static int yae_adjust_position(ATempoContext *atempo)
                                                                         \
         scalar_type *out     = (scalar_type *)dst;                      \
         scalar_type *out_end = (scalar_type *)dst_end;                  \
+        const int channels   = atempo->channels;                        \
+        const int64_t n      = FFMIN(overlap,                           \
+                                     (out_end - out) / channels);       \
+        const int64_t n0     = av_clip64(-frag->position[0], 0, n);     \
         int64_t i;                                                      \
                                                                         \
-        for (i = 0; i < overlap && out < out_end;                       \
-             i++, atempo->position[1]++, wa++, wb++) {                  \
-            float w0 = *wa;                                             \
-            float w1 = *wb;                                             \
+        /* the current fragment starts before the stream does, */      \
+        /* pass the previous fragment through until then:      */      \
+        memcpy(out, aaa, n0 * atempo->stride);                          \
+        aaa += n0 * channels;                                           \
+        bbb += n0 * channels;                                           \
+        out += n0 * channels;                                           \
+                                                                        \
+        for (i = n0; i < n; i++) {                                      \
+            const float w0 = wa[i];                                     \
+            const float w1 = wb[i];                                     \
             int j;                                                      \
                                                                         \
-            for (j = 0; j < atempo->channels;                           \
-                 j++, aaa++, bbb++, out++) {                            \
-                float t0 = (float)*aaa;                                 \
-                float t1 = (float)*bbb;                                 \
+            for (j = 0; j < channels; j++) {                            \
+                float t0 = (float)aaa[j];                               \
+                float t1 = (float)bbb[j];                               \
                                                                         \
-                *out =                                                  \
-                    frag->position[0] + i < 0 ?                         \
-                    *aaa :                                              \
-                    (scalar_type)(t0 * w0 + t1 * w1);                   \
+                out[j] = (scalar_type)(t0 * w0 + t1 * w1);              \
             }                                                           \
+                                                                        \
+            aaa += channels;                                            \
+            bbb += channels;                                            \
+            out += channels;                                            \
         }                                                               \
+                                                                        \
+        atempo->position[1] += n;                                       \
         dst = (uint8_t *)out;                                           \
     } while (0)
 
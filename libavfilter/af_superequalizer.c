@@ -46,11 +46,17 @@ typedef struct SuperEqualizerContext {
     float aa;
     float iza;
     float *ires, *irest;
-    float *fsamples;
     int winlen, tabsize;
+    int wb;
 
     AVFrame *in, *out;
-    RDFTContext *rdft, *irdft;
+    RDFTContext *rdft;
+
+    /* one set of transforms and buffers for each channel,
+     * so that the channels can be filtered in parallel */
+    int nb_channels;
+    RDFTContext **ch_rdft, **ch_irdft;
+    float **fsamples;
 } SuperEqualizerContext;
 
 static const float bands[] = {
@@ -137,17 +143,19 @@ static int equ_init(SuperEqualizerContext *s, int wb)
     int i,j;
 
     s->rdft  = av_rdft_init(wb, DFT_R2C);
-    s->irdft = av_rdft_init(wb, IDFT_C2R);
-    if (!s->rdft || !s->irdft)
+    if (!s->rdft)
         return AVERROR(ENOMEM);
 
+    s->wb = wb;
+
     s->aa = 96;
     s->winlen = (1 << (wb-1))-1;
     s->tabsize  = 1 << wb;
 
     s->ires     = av_calloc(s->tabsize, sizeof(float));
     s->irest    = av_calloc(s->tabsize, sizeof(float));
-    s->fsamples = av_calloc(s->tabsize, sizeof(float));
+    if (!s->ires || !s->irest)
+        return AVERROR(ENOMEM);
 
     for (i = 0; i <= M; i++) {
         s->fact[i] = 1;
@@ -182,34 +190,33 @@ static void make_fir(SuperEqualizerContext *s, float *lbc, float *rbc, EqParamet
         nires[i] = s->irest[i];
 }
 
-static int filter_frame(AVFilterLink *inlink, AVFrame *in)
+typedef struct ThreadData {
+    AVFrame *in, *out;
+} ThreadData;
+
+static int filter_channels(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    AVFilterContext *ctx = inlink->dst;
     SuperEqualizerContext *s = ctx->priv;
-    AVFilterLink *outlink = ctx->outputs[0];
+    ThreadData *td = arg;
+    AVFrame *in = td->in;
+    AVFrame *out = td->out;
     const float *ires = s->ires;
-    float *fsamples = s->fsamples;
+    const int start = (in->channels * jobnr) / nb_jobs;
+    const int end = (in->channels * (jobnr+1)) / nb_jobs;
     int ch, i;
 
-    AVFrame *out = ff_get_audio_buffer(outlink, s->winlen);
-    float *src, *dst, *ptr;
-
-    if (!out) {
-        av_frame_free(&in);
-        return AVERROR(ENOMEM);
-    }
-
-    for (ch = 0; ch < in->channels; ch++) {
-        ptr = (float *)out->extended_data[ch];
-        dst = (float *)s->out->extended_data[ch];
-        src = (float *)in->extended_data[ch];
+    for (ch = start; ch < end; ch++) {
+        float *fsamples = s->fsamples[ch];
+        float *ptr = (float *)out->extended_data[ch];
+        float *dst = (float *)s->out->extended_data[ch];
+        const float *src = (const float *)in->extended_data[ch];
 
         for (i = 0; i < in->nb_samples; i++)
             fsamples[i] = src[i];
         for (; i < s->tabsize; i++)
             fsamples[i] = 0;
 
-        av_rdft_calc(s->rdft, fsamples);
+        av_rdft_calc(s->ch_rdft[ch], fsamples);
 
         fsamples[0] = ires[0] * fsamples[0];
         fsamples[1] = ires[1] * fsamples[1];
@@ -223,7 +230,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
             fsamples[i*2+1] = im;
         }
 
-        av_rdft_calc(s->irdft, fsamples);
+        av_rdft_calc(s->ch_irdft[ch], fsamples);
 
         for (i = 0; i < s->winlen; i++)
             dst[i] += fsamples[i] / s->tabsize * 2;
@@ -235,6 +242,27 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
             dst[i] = dst[i+s->winlen];
     }
 
+    return 0;
+}
+
+static int filter_frame(AVFilterLink *inlink, AVFrame *in)
+{
+    AVFilterContext *ctx = inlink->dst;
+    SuperEqualizerContext *s = ctx->priv;
+    AVFilterLink *outlink = ctx->outputs[0];
+    ThreadData td;
+    AVFrame *out = ff_get_audio_buffer(outlink, s->winlen);
+
+    if (!out) {
+        av_frame_free(&in);
+        return AVERROR(ENOMEM);
+    }
+
+    td.in  = in;
+    td.out = out;
+    ctx->internal->execute(ctx, filter_channels, &td, NULL,
+                           FFMIN(in->channels, ff_filter_get_nb_threads(ctx)));
+
     out->pts = in->pts;
     av_frame_free(&in);
 
@@ -304,6 +332,21 @@ static int config_input(AVFilterLink *inlink)
     if (!s->out)
         return AVERROR(ENOMEM);
 
+    s->nb_channels = inlink->channels;
+    s->ch_rdft  = av_calloc(s->nb_channels, sizeof(*s->ch_rdft));
+    s->ch_irdft = av_calloc(s->nb_channels, sizeof(*s->ch_irdft));
+    s->fsamples = av_calloc(s->nb_channels, sizeof(*s->fsamples));
+    if (!s->ch_rdft || !s->ch_irdft || !s->fsamples)
+        return AVERROR(ENOMEM);
+
+    for (int ch = 0; ch < s->nb_channels; ch++) {
+        s->ch_rdft[ch]  = av_rdft_init(s->wb, DFT_R2C);
+        s->ch_irdft[ch] = av_rdft_init(s->wb, IDFT_C2R);
+        s->fsamples[ch] = av_calloc(s->tabsize, sizeof(**s->fsamples));
+        if (!s->ch_rdft[ch] || !s->ch_irdft[ch] || !s->fsamples[ch])
+            return AVERROR(ENOMEM);
+    }
+
     return 0;
 }
 
@@ -324,9 +367,18 @@ static av_cold void uninit(AVFilterContext *ctx)
     av_frame_free(&s->out);
     av_freep(&s->irest);
     av_freep(&s->ires);
-    av_freep(&s->fsamples);
     av_rdft_end(s->rdft);
-    av_rdft_end(s->irdft);
+    for (int ch = 0; ch < s->nb_channels; ch++) {
+        if (s->ch_rdft)
+            av_rdft_end(s->ch_rdft[ch]);
+        if (s->ch_irdft)
+            av_rdft_end(s->ch_irdft[ch]);
+        if (s->fsamples)
+            av_freep(&s->fsamples[ch]);
+    }
+    av_freep(&s->ch_rdft);
+    av_freep(&s->ch_irdft);
+    av_freep(&s->fsamples);
 }
 
 static const AVFilterPad superequalizer_inputs[] = {
@@ -385,4 +437,5 @@ AVFilter ff_af_superequalizer = {
     .uninit        = uninit,
     .inputs        = superequalizer_inputs,
     .outputs       = superequalizer_outputs,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -28,13 +28,13 @@
 
 #include <math.h>
 
-#include "libavcodec/avfft.h"
 #include "libavutil/audio_fifo.h"
 #include "libavutil/avassert.h"
 #include "libavutil/avstring.h"
 #include "libavutil/channel_layout.h"
 #include "libavutil/opt.h"
 #include "libavutil/parseutils.h"
+#include "libavutil/tx.h"
 #include "libavutil/xga_font_data.h"
 #include "audio.h"
 #include "video.h"
@@ -72,11 +72,13 @@ typedef struct ShowSpectrumContext {
     int start, stop;            ///< zoom mode
     int data;
     int xpos;                   ///< x position (current column)
-    FFTContext **fft;           ///< Fast Fourier Transform context
-    FFTContext **ifft;          ///< Inverse Fast Fourier Transform context
+    AVTXContext **fft;          ///< Fast Fourier Transform context
+    AVTXContext **ifft;         ///< Inverse Fast Fourier Transform context
+    av_tx_fn tx_fn;
+    av_tx_fn itx_fn;
     int fft_bits;               ///< number of bits (FFT window size = 1<<fft_bits)
-    FFTComplex **fft_data;      ///< bins holder for each (displayed) channels
-    FFTComplex **fft_scratch;   ///< scratch buffers
+    AVComplexFloat **fft_data;      ///< bins holder for each (displayed) channels
+    AVComplexFloat **fft_scratch;   ///< scratch buffers
     float *window_func_lut;     ///< Window function LUT
     float **magnitudes;
     float **phases;
@@ -305,12 +307,12 @@ static av_cold void uninit(AVFilterContext *ctx)
     av_freep(&s->combine_buffer);
     if (s->fft) {
         for (i = 0; i < s->nb_display_channels; i++)
-            av_fft_end(s->fft[i]);
+            av_tx_uninit(&s->fft[i]);
     }
     av_freep(&s->fft);
     if (s->ifft) {
         for (i = 0; i < s->nb_display_channels; i++)
-            av_fft_end(s->ifft[i]);
+            av_tx_uninit(&s->ifft[i]);
     }
     av_freep(&s->ifft);
     if (s->fft_data) {
@@ -393,8 +395,8 @@ static int run_channel_fft(AVFilterContext *ctx, void *arg, int jobnr, int nb_jo
 
     if (s->stop) {
         float theta, phi, psi, a, b, S, c;
-        FFTComplex *g = s->fft_data[ch];
-        FFTComplex *h = s->fft_scratch[ch];
+        AVComplexFloat *g = s->fft_data[ch];
+        AVComplexFloat *h = s->fft_scratch[ch];
         int L = s->buf_size;
         int N = s->win_size;
         int M = s->win_size / 2;
@@ -437,11 +439,9 @@ static int run_channel_fft(AVFilterContext *ctx, void *arg, int jobnr, int nb_jo
             g[n].im = b;
         }
 
-        av_fft_permute(s->fft[ch], h);
-        av_fft_calc(s->fft[ch], h);
+        s->tx_fn(s->fft[ch], h, h, sizeof(float));
 
-        av_fft_permute(s->fft[ch], g);
-        av_fft_calc(s->fft[ch], g);
+        s->tx_fn(s->fft[ch], g, g, sizeof(float));
 
         for (int n = 0; n < L; n++) {
             c = g[n].re;
@@ -453,8 +453,7 @@ static int run_channel_fft(AVFilterContext *ctx, void *arg, int jobnr, int nb_jo
             g[n].im = b / L;
         }
 
-        av_fft_permute(s->ifft[ch], g);
-        av_fft_calc(s->ifft[ch], g);
+        s->itx_fn(s->ifft[ch], g, g, sizeof(float));
 
         for (int k = 0; k < M; k++) {
             psi = k * k / 2.f * phi;
@@ -467,8 +466,7 @@ static int run_channel_fft(AVFilterContext *ctx, void *arg, int jobnr, int nb_jo
         }
     } else {
         /* run FFT on each samples set */
-        av_fft_permute(s->fft[ch], s->fft_data[ch]);
-        av_fft_calc(s->fft[ch], s->fft_data[ch]);
+        s->tx_fn(s->fft[ch], s->fft_data[ch], s->fft_data[ch], sizeof(float));
     }
 
     return 0;
@@ -986,7 +984,7 @@ static int config_output(AVFilterLink *outlink)
     AVFilterContext *ctx = outlink->src;
     AVFilterLink *inlink = ctx->inputs[0];
     ShowSpectrumContext *s = ctx->priv;
-    int i, fft_bits, h, w;
+    int i, fft_bits, h, w, ret;
     float overlap;
 
     switch (s->fscale) {
@@ -1056,30 +1054,34 @@ static int config_output(AVFilterLink *outlink)
          * make sure the buffer is aligned in memory for the FFT functions. */
         for (i = 0; i < s->nb_display_channels; i++) {
             if (s->stop) {
-                av_fft_end(s->ifft[i]);
+                av_tx_uninit(&s->ifft[i]);
                 av_freep(&s->fft_scratch[i]);
             }
-            av_fft_end(s->fft[i]);
+            av_tx_uninit(&s->fft[i]);
             av_freep(&s->fft_data[i]);
         }
         av_freep(&s->fft_data);
 
         s->nb_display_channels = inlink->channels;
         for (i = 0; i < s->nb_display_channels; i++) {
-            s->fft[i] = av_fft_init(fft_bits + !!s->stop, 0);
+            float scale = 1.f;
+
+            ret = av_tx_init(&s->fft[i], &s->tx_fn, AV_TX_FLOAT_FFT, 0,
+                             1 << (fft_bits + !!s->stop), &scale, AV_TX_INPLACE);
+            if (ret < 0) {
+                av_log(ctx, AV_LOG_ERROR, "Unable to create FFT context. "
+                       "The window size might be too high.\n");
+                return AVERROR(EINVAL);
+            }
             if (s->stop) {
-                s->ifft[i] = av_fft_init(fft_bits + !!s->stop, 1);
-                if (!s->ifft[i]) {
+                ret = av_tx_init(&s->ifft[i], &s->itx_fn, AV_TX_FLOAT_FFT, 1,
+                                 1 << (fft_bits + !!s->stop), &scale, AV_TX_INPLACE);
+                if (ret < 0) {
                     av_log(ctx, AV_LOG_ERROR, "Unable to create Inverse FFT context. "
                            "The window size might be too high.\n");
                     return AVERROR(EINVAL);
                 }
             }
-            if (!s->fft[i]) {
-                av_log(ctx, AV_LOG_ERROR, "Unable to create FFT context. "
-                       "The window size might be too high.\n");
-                return AVERROR(EINVAL);
-            }
         }
 
         s->magnitudes = av_calloc(s->nb_display_channels, sizeof(*s->magnitudes));
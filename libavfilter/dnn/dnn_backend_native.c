@@ -26,13 +26,17 @@
 #include "dnn_backend_native.h"
 #include "libavutil/avassert.h"
 #include "dnn_backend_native_layer_conv2d.h"
+#include "dnn_backend_native_layer_dense.h"
 #include "dnn_backend_native_layers.h"
 #include "dnn_io_proc.h"
+#include "../internal.h"
 
 #define OFFSET(x) offsetof(NativeContext, x)
 #define FLAGS AV_OPT_FLAG_FILTERING_PARAM
 static const AVOption dnn_native_options[] = {
     { "conv2d_threads", "threads num for conv2d layer", OFFSET(options.conv2d_threads), AV_OPT_TYPE_INT,  { .i64 = 0 }, INT_MIN, INT_MAX, FLAGS },
+    { "nireq",          "number of request",            OFFSET(options.nireq),          AV_OPT_TYPE_INT,  { .i64 = 0 }, 0, INT_MAX, FLAGS },
+    { "batch_size",     "batch size per request",       OFFSET(options.batch_size),     AV_OPT_TYPE_INT,  { .i64 = 1 }, 1, 1000, FLAGS },
     { NULL },
 };
 
@@ -44,7 +48,31 @@ static const AVClass dnn_native_class = {
     .category   = AV_CLASS_CATEGORY_FILTER,
 };
 
-static DNNReturnType execute_model_native(const DNNModel *model, const char *input_name, AVFrame *in_frame,
+typedef struct NativeTask {
+    const char *input_name;
+    AVFrame *in_frame;
+    const char *output_name;
+    AVFrame *out_frame;
+    DNNReturnType ret;
+    int done;
+} NativeTask;
+
+struct NativeRequest {
+    NativeTask **tasks;
+    int task_count;
+};
+
+struct NativeWorker {
+    NativeModel *native_model;
+    /* private copy of the operands, so that workers do not share buffers */
+    DnnOperand *operands;
+#if HAVE_PTHREAD_CANCEL
+    pthread_t thread;
+#endif
+};
+
+static DNNReturnType execute_model_native(const DNNModel *model, DnnOperand *operands,
+                                          const char *input_name, AVFrame *in_frame,
                                           const char **output_names, uint32_t nb_output, AVFrame *out_frame,
                                           int do_ioproc);
 
@@ -99,7 +127,8 @@ static DNNReturnType get_output_native(void *model, const char *input_name, int
     in_frame->width = input_width;
     in_frame->height = input_height;
 
-    ret = execute_model_native(native_model->model, input_name, in_frame, &output_name, 1, out_frame, 0);
+    ret = execute_model_native(native_model->model, native_model->operands, input_name, in_frame,
+                               &output_name, 1, out_frame, 0);
     *output_width = out_frame->width;
     *output_height = out_frame->height;
 
@@ -161,10 +190,13 @@ DNNModel *ff_dnn_load_model_native(const char *model_filename, DNNFunctionType f
     model->model = native_model;
 
     native_model->ctx.class = &dnn_native_class;
+    ff_mutex_init(&native_model->task_mutex, NULL);
     model->options = options;
     if (av_opt_set_from_string(&native_model->ctx, model->options, NULL, "=", "&") < 0)
         goto fail;
     native_model->model = model;
+    // the tensorflow backend loads native models without a filter
+    native_model->ctx.nb_threads = filter_ctx ? ff_filter_get_nb_threads(filter_ctx) : 1;
 
 #if !HAVE_PTHREAD_CANCEL
     if (native_model->ctx.options.conv2d_threads > 1){
@@ -258,7 +290,8 @@ fail:
     return NULL;
 }
 
-static DNNReturnType execute_model_native(const DNNModel *model, const char *input_name, AVFrame *in_frame,
+static DNNReturnType execute_model_native(const DNNModel *model, DnnOperand *operands,
+                                          const char *input_name, AVFrame *in_frame,
                                           const char **output_names, uint32_t nb_output, AVFrame *out_frame,
                                           int do_ioproc)
 {
@@ -274,7 +307,7 @@ static DNNReturnType execute_model_native(const DNNModel *model, const char *inp
     }
 
     for (int i = 0; i < native_model->operands_num; ++i) {
-        oprd = &native_model->operands[i];
+        oprd = &operands[i];
         if (strcmp(oprd->name, input_name) == 0) {
             if (oprd->type != DOT_INPUT) {
                 av_log(ctx, AV_LOG_ERROR, "Found \"%s\" in model, but it is not input node\n", input_name);
@@ -326,7 +359,7 @@ static DNNReturnType execute_model_native(const DNNModel *model, const char *inp
 
     for (layer = 0; layer < native_model->layers_num; ++layer){
         DNNLayerType layer_type = native_model->layers[layer].type;
-        if (ff_layer_funcs[layer_type].pf_exec(native_model->operands,
+        if (ff_layer_funcs[layer_type].pf_exec(operands,
                                             native_model->layers[layer].input_operand_indexes,
                                             native_model->layers[layer].output_operand_index,
                                             native_model->layers[layer].params,
@@ -340,8 +373,8 @@ static DNNReturnType execute_model_native(const DNNModel *model, const char *inp
         DnnOperand *oprd = NULL;
         const char *output_name = output_names[i];
         for (int j = 0; j < native_model->operands_num; ++j) {
-            if (strcmp(native_model->operands[j].name, output_name) == 0) {
-                oprd = &native_model->operands[j];
+            if (strcmp(operands[j].name, output_name) == 0) {
+                oprd = &operands[j];
                 break;
             }
         }
@@ -388,7 +421,232 @@ DNNReturnType ff_dnn_execute_model_native(const DNNModel *model, const char *inp
         return DNN_ERROR;
     }
 
-    return execute_model_native(model, input_name, in_frame, output_names, nb_output, out_frame, 1);
+    return execute_model_native(model, native_model->operands, input_name, in_frame,
+                                output_names, nb_output, out_frame, 1);
+}
+
+static void free_request(NativeRequest **request)
+{
+    if (!*request)
+        return;
+    av_freep(&(*request)->tasks);
+    av_freep(request);
+}
+
+static NativeRequest *alloc_request(NativeModel *native_model)
+{
+    NativeRequest *request = av_mallocz(sizeof(*request));
+    if (!request)
+        return NULL;
+    request->tasks = av_malloc_array(native_model->ctx.options.batch_size, sizeof(*request->tasks));
+    if (!request->tasks)
+        av_freep(&request);
+    return request;
+}
+
+static void run_request(NativeModel *native_model, DnnOperand *operands, NativeRequest *request)
+{
+    for (int i = 0; i < request->task_count; i++) {
+        NativeTask *task = request->tasks[i];
+        task->ret = execute_model_native(native_model->model, operands, task->input_name, task->in_frame,
+                                         &task->output_name, 1, task->out_frame, 1);
+        ff_mutex_lock(&native_model->task_mutex);
+        task->done = 1;
+        ff_mutex_unlock(&native_model->task_mutex);
+    }
+}
+
+#if HAVE_PTHREAD_CANCEL
+static void *native_worker(void *arg)
+{
+    NativeWorker *worker = arg;
+    NativeModel *native_model = worker->native_model;
+
+    while (1) {
+        // a NULL request asks the worker to exit
+        NativeRequest *request = ff_safe_queue_pop_front(native_model->request_queue);
+        if (!request)
+            break;
+        run_request(native_model, worker->operands, request);
+        free_request(&request);
+    }
+
+    return NULL;
+}
+#endif
+
+static DNNReturnType init_workers_native(NativeModel *native_model)
+{
+    NativeContext *ctx = &native_model->ctx;
+
+    native_model->request_queue = ff_safe_queue_create();
+    native_model->task_queue = ff_queue_create();
+    if (!native_model->request_queue || !native_model->task_queue)
+        goto err;
+
+#if HAVE_PTHREAD_CANCEL
+    if (ctx->options.nireq <= 0) {
+        // the default value is a rough estimation
+        ctx->options.nireq = ctx->nb_threads / 2 + 1;
+    }
+    // the workers share the filter threads, don't let each of them use all
+    ctx->nb_threads = FFMAX(ctx->nb_threads / ctx->options.nireq, 1);
+
+    native_model->workers = av_mallocz_array(ctx->options.nireq, sizeof(*native_model->workers));
+    if (!native_model->workers)
+        goto err;
+
+    for (int i = 0; i < ctx->options.nireq; i++) {
+        NativeWorker *worker = &native_model->workers[i];
+
+        worker->native_model = native_model;
+        worker->operands = av_malloc_array(native_model->operands_num, sizeof(*worker->operands));
+        if (!worker->operands)
+            goto err;
+        memcpy(worker->operands, native_model->operands,
+               native_model->operands_num * sizeof(*worker->operands));
+        for (int j = 0; j < native_model->operands_num; j++)
+            worker->operands[j].data = NULL;
+
+        if (pthread_create(&worker->thread, NULL, native_worker, worker)) {
+            av_freep(&worker->operands);
+            goto err;
+        }
+        native_model->nb_workers++;
+    }
+#endif
+
+    return DNN_SUCCESS;
+
+err:
+    av_log(ctx, AV_LOG_ERROR, "Failed to create workers for async execution\n");
+    return DNN_ERROR;
+}
+
+static DNNReturnType submit_request_native(NativeModel *native_model)
+{
+    NativeRequest *request = native_model->request;
+
+    native_model->request = NULL;
+    if (!native_model->nb_workers) {
+        // no thread support, run the request right away
+        run_request(native_model, native_model->operands, request);
+        free_request(&request);
+        return DNN_SUCCESS;
+    }
+
+    if (ff_safe_queue_push_back(native_model->request_queue, request) < 0) {
+        free_request(&request);
+        av_log(&native_model->ctx, AV_LOG_ERROR, "Failed to push back request_queue.\n");
+        return DNN_ERROR;
+    }
+    return DNN_SUCCESS;
+}
+
+DNNReturnType ff_dnn_execute_model_async_native(const DNNModel *model, const char *input_name, AVFrame *in_frame,
+                                                const char **output_names, uint32_t nb_output, AVFrame *out_frame)
+{
+    NativeModel *native_model = model->model;
+    NativeContext *ctx = &native_model->ctx;
+    NativeTask *task;
+
+    if (!in_frame) {
+        av_log(ctx, AV_LOG_ERROR, "in frame is NULL when async execute model.\n");
+        return DNN_ERROR;
+    }
+
+    if (!out_frame) {
+        av_log(ctx, AV_LOG_ERROR, "out frame is NULL when async execute model.\n");
+        return DNN_ERROR;
+    }
+
+    if (nb_output != 1) {
+        avpriv_report_missing_feature(ctx, "multiple outputs");
+        return DNN_ERROR;
+    }
+
+    if (!native_model->task_queue) {
+        if (init_workers_native(native_model) != DNN_SUCCESS)
+            return DNN_ERROR;
+    }
+
+    if (!native_model->request) {
+        native_model->request = alloc_request(native_model);
+        if (!native_model->request) {
+            av_log(ctx, AV_LOG_ERROR, "unable to alloc memory for request item.\n");
+            return DNN_ERROR;
+        }
+    }
+
+    task = av_malloc(sizeof(*task));
+    if (!task) {
+        av_log(ctx, AV_LOG_ERROR, "unable to alloc memory for task item.\n");
+        return DNN_ERROR;
+    }
+
+    task->done = 0;
+    task->ret = DNN_SUCCESS;
+    task->input_name = input_name;
+    task->in_frame = in_frame;
+    task->output_name = output_names[0];
+    task->out_frame = out_frame;
+    if (ff_queue_push_back(native_model->task_queue, task) < 0) {
+        av_freep(&task);
+        av_log(ctx, AV_LOG_ERROR, "unable to push back task_queue.\n");
+        return DNN_ERROR;
+    }
+
+    native_model->request->tasks[native_model->request->task_count++] = task;
+    if (native_model->request->task_count < ctx->options.batch_size)
+        return DNN_SUCCESS;
+
+    return submit_request_native(native_model);
+}
+
+DNNAsyncStatusType ff_dnn_get_async_result_native(const DNNModel *model, AVFrame **in, AVFrame **out)
+{
+    NativeModel *native_model = model->model;
+    NativeTask *task = ff_queue_peek_front(native_model->task_queue);
+    DNNReturnType ret;
+    int done;
+
+    if (!task) {
+        return DAST_EMPTY_QUEUE;
+    }
+
+    ff_mutex_lock(&native_model->task_mutex);
+    done = task->done;
+    ff_mutex_unlock(&native_model->task_mutex);
+    if (!done) {
+        return DAST_NOT_READY;
+    }
+
+    ff_queue_pop_front(native_model->task_queue);
+    ret = task->ret;
+    if (ret != DNN_SUCCESS) {
+        av_frame_free(&task->in_frame);
+        av_frame_free(&task->out_frame);
+        av_freep(&task);
+        return DAST_FAIL;
+    }
+
+    *in = task->in_frame;
+    *out = task->out_frame;
+    av_freep(&task);
+
+    return DAST_SUCCESS;
+}
+
+DNNReturnType ff_dnn_flush_native(const DNNModel *model)
+{
+    NativeModel *native_model = model->model;
+
+    if (!native_model->request || !native_model->request->task_count) {
+        // no pending task need to flush
+        return DNN_SUCCESS;
+    }
+
+    return submit_request_native(native_model);
 }
 
 int32_t ff_calculate_operand_dims_count(const DnnOperand *oprd)
@@ -416,18 +674,50 @@ void ff_dnn_free_model_native(DNNModel **model)
 {
     NativeModel *native_model;
     ConvolutionalParams *conv_params;
+    DenseParams *dense_params;
     int32_t layer;
 
     if (*model)
     {
         if ((*model)->model) {
             native_model = (*model)->model;
+#if HAVE_PTHREAD_CANCEL
+            for (int i = 0; i < native_model->nb_workers; i++)
+                ff_safe_queue_push_back(native_model->request_queue, NULL);
+            for (int i = 0; i < native_model->nb_workers; i++) {
+                NativeWorker *worker = &native_model->workers[i];
+                pthread_join(worker->thread, NULL);
+                for (int j = 0; j < native_model->operands_num; j++)
+                    av_freep(&worker->operands[j].data);
+                av_freep(&worker->operands);
+            }
+#endif
+            av_freep(&native_model->workers);
+            free_request(&native_model->request);
+            ff_safe_queue_destroy(native_model->request_queue);
+            while (ff_queue_size(native_model->task_queue) != 0) {
+                NativeTask *task = ff_queue_pop_front(native_model->task_queue);
+                av_frame_free(&task->in_frame);
+                av_frame_free(&task->out_frame);
+                av_freep(&task);
+            }
+            ff_queue_destroy(native_model->task_queue);
+            ff_mutex_destroy(&native_model->task_mutex);
+
             if (native_model->layers) {
                 for (layer = 0; layer < native_model->layers_num; ++layer){
                     if (native_model->layers[layer].type == DLT_CONV2D){
                         conv_params = (ConvolutionalParams *)native_model->layers[layer].params;
                         av_freep(&conv_params->kernel);
                         av_freep(&conv_params->biases);
+                        av_freep(&conv_params->packed_kernel);
+                        av_freep(&conv_params->fdsp);
+                    } else if (native_model->layers[layer].type == DLT_DENSE) {
+                        dense_params = (DenseParams *)native_model->layers[layer].params;
+                        av_freep(&dense_params->kernel);
+                        av_freep(&dense_params->biases);
+                        av_freep(&dense_params->packed_kernel);
+                        av_freep(&dense_params->fdsp);
                     }
                     av_freep(&native_model->layers[layer].params);
                 }
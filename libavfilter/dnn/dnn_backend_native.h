@@ -30,6 +30,9 @@
 #include "../dnn_interface.h"
 #include "libavformat/avio.h"
 #include "libavutil/opt.h"
+#include "libavutil/thread.h"
+#include "queue.h"
+#include "safe_queue.h"
 
 /**
  * the enum value of DNNLayerType should not be changed,
@@ -111,13 +114,19 @@ typedef struct InputParams{
 
 typedef struct NativeOptions{
     uint32_t conv2d_threads;
+    int nireq;
+    int batch_size;
 } NativeOptions;
 
 typedef struct NativeContext {
     const AVClass *class;
     NativeOptions options;
+    int nb_threads;             // threads available to one execution of the network
 } NativeContext;
 
+typedef struct NativeWorker NativeWorker;
+typedef struct NativeRequest NativeRequest;
+
 // Represents simple feed-forward convolutional network.
 typedef struct NativeModel{
     NativeContext ctx;
@@ -126,6 +135,14 @@ typedef struct NativeModel{
     int32_t layers_num;
     DnnOperand *operands;
     int32_t operands_num;
+
+    /* for async execution */
+    NativeWorker *workers;      // each worker runs the network on its own operands
+    int nb_workers;
+    SafeQueue *request_queue;   // holds NativeRequest to be run by the workers
+    Queue *task_queue;          // holds NativeTask in submission order
+    NativeRequest *request;     // request being filled with up to batch_size tasks
+    AVMutex task_mutex;         // protects the done flag of the tasks
 } NativeModel;
 
 DNNModel *ff_dnn_load_model_native(const char *model_filename, DNNFunctionType func_type, const char *options, AVFilterContext *filter_ctx);
@@ -133,6 +150,13 @@ DNNModel *ff_dnn_load_model_native(const char *model_filename, DNNFunctionType f
 DNNReturnType ff_dnn_execute_model_native(const DNNModel *model, const char *input_name, AVFrame *in_frame,
                                           const char **output_names, uint32_t nb_output, AVFrame *out_frame);
 
+DNNReturnType ff_dnn_execute_model_async_native(const DNNModel *model, const char *input_name, AVFrame *in_frame,
+                                                const char **output_names, uint32_t nb_output, AVFrame *out_frame);
+
+DNNAsyncStatusType ff_dnn_get_async_result_native(const DNNModel *model, AVFrame **in, AVFrame **out);
+
+DNNReturnType ff_dnn_flush_native(const DNNModel *model);
+
 void ff_dnn_free_model_native(DNNModel **model);
 
 // NOTE: User must check for error (return value <= 0) to handle
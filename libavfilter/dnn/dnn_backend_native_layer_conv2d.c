@@ -21,10 +21,14 @@
 #include "libavutil/avassert.h"
 #include "libavutil/thread.h"
 #include "libavutil/cpu.h"
+#include "libavutil/float_dsp.h"
 #include "dnn_backend_native_layer_conv2d.h"
 
 #define CLAMP_TO_EDGE(x, w) ((x) < 0 ? 0 : ((x) >= (w) ? (w - 1) : (x)))
 
+/* number of output pixels whose input patches are gathered at once */
+#define PATCH_TILE 32
+
 //struct to pass parameters
 typedef struct ThreadCommonParam{
     DnnOperand *operands;
@@ -33,16 +37,42 @@ typedef struct ThreadCommonParam{
     const void *parameters;
     NativeContext *ctx;
     float *output_data;
+    int patch_len;
 } ThreadCommonParam;
 
 typedef struct ThreadParam{
     ThreadCommonParam *thread_common_param;
     int thread_start, thread_end;
+    /* PATCH_TILE input patches, each zero padded to patch_len */
+    float *patches;
 #if HAVE_PTHREAD_CANCEL
     pthread_t thread;
 #endif
 } ThreadParam;
 
+/**
+ * Repack the kernel for the scalar products of the execution, once
+ * per model instead of on every call.
+ */
+int ff_dnn_init_layer_conv2d(ConvolutionalParams *conv_params)
+{
+    int filter_size = conv_params->kernel_size * conv_params->kernel_size * conv_params->input_num;
+    int patch_len = FFALIGN(filter_size, 16);
+
+    conv_params->fdsp = avpriv_float_dsp_alloc(0);
+    conv_params->packed_kernel = av_calloc(conv_params->output_num, patch_len * sizeof(float));
+    if (!conv_params->fdsp || !conv_params->packed_kernel) {
+        av_freep(&conv_params->fdsp);
+        av_freep(&conv_params->packed_kernel);
+        return AVERROR(ENOMEM);
+    }
+    for (int i = 0; i < conv_params->output_num; i++)
+        memcpy(conv_params->packed_kernel + i * patch_len, conv_params->kernel + i * filter_size,
+               filter_size * sizeof(float));
+
+    return 0;
+}
+
 int ff_dnn_load_layer_conv2d(Layer *layer, AVIOContext *model_file_context, int file_size, int operands_num)
 {
     ConvolutionalParams *conv_params;
@@ -95,6 +125,13 @@ int ff_dnn_load_layer_conv2d(Layer *layer, AVIOContext *model_file_context, int
         }
     }
 
+    if (ff_dnn_init_layer_conv2d(conv_params) < 0) {
+        av_freep(&conv_params->biases);
+        av_freep(&conv_params->kernel);
+        av_freep(&conv_params);
+        return 0;
+    }
+
     layer->params = conv_params;
 
     layer->input_operand_indexes[0] = (int32_t)avio_rl32(model_file_context);
@@ -108,6 +145,51 @@ int ff_dnn_load_layer_conv2d(Layer *layer, AVIOContext *model_file_context, int
     return dnn_size;
 }
 
+static float activate(float value, DNNActivationFunc activation)
+{
+    switch (activation){
+    case RELU:
+        return FFMAX(value, 0.0);
+    case TANH:
+        return 2.0f  / (1.0f + exp(-2.0f * value)) - 1.0f;
+    case SIGMOID:
+        return 1.0f / (1.0f + exp(-value));
+    case LEAKY_RELU:
+        return FFMAX(value, 0.0) + 0.2 * FFMIN(value, 0.0);
+    case NONE:
+    default:
+        return value;
+    }
+}
+
+/**
+ * Copy the input pixels covered by the kernel centered on (x, y) into patch,
+ * in the same order as the kernel coefficients of one output channel.
+ */
+static void gather_patch(float *patch, const float *input, int x, int y,
+                         int width, int height, const ConvolutionalParams *conv_params)
+{
+    int radius = conv_params->kernel_size >> 1;
+    int src_linesize = width * conv_params->input_num;
+    size_t pel_size = conv_params->input_num * sizeof(*patch);
+
+    for (int kernel_y = 0; kernel_y < conv_params->kernel_size; ++kernel_y) {
+        int y_pos = y + (kernel_y - radius) * conv_params->dilation;
+        for (int kernel_x = 0; kernel_x < conv_params->kernel_size; ++kernel_x) {
+            int x_pos = x + (kernel_x - radius) * conv_params->dilation;
+            if (conv_params->padding_method == SAME_CLAMP_TO_EDGE) {
+                memcpy(patch, input + CLAMP_TO_EDGE(y_pos, height) * src_linesize +
+                       CLAMP_TO_EDGE(x_pos, width) * conv_params->input_num, pel_size);
+            } else if (x_pos < 0 || x_pos >= width || y_pos < 0 || y_pos >= height) {
+                memset(patch, 0, pel_size);
+            } else {
+                memcpy(patch, input + y_pos * src_linesize + x_pos * conv_params->input_num, pel_size);
+            }
+            patch += conv_params->input_num;
+        }
+    }
+}
+
 static void * dnn_execute_layer_conv2d_thread(void *threadarg)
 {
     //pass parameters
@@ -120,11 +202,11 @@ static void * dnn_execute_layer_conv2d_thread(void *threadarg)
     int channel = operands[input_operand_index].dims[3];
     const float *input = operands[input_operand_index].data;
     const ConvolutionalParams *conv_params = thread_common_param->parameters;
+    const AVFloatDSPContext *fdsp = conv_params->fdsp;
+    const float *kernel = conv_params->packed_kernel;
+    int patch_len = thread_common_param->patch_len;
+    float *patches = thread_param->patches;
 
-    int radius = conv_params->kernel_size >> 1;
-    int src_linesize = width * conv_params->input_num;
-    int filter_linesize = conv_params->kernel_size * conv_params->input_num;
-    int filter_size = conv_params->kernel_size * filter_linesize;
     int pad_size = (conv_params->padding_method == VALID) ? (conv_params->kernel_size - 1) / 2 * conv_params->dilation : 0;
 
     float *output = thread_common_param->output_data;
@@ -132,52 +214,26 @@ static void * dnn_execute_layer_conv2d_thread(void *threadarg)
 
     av_assert0(channel == conv_params->input_num);
 
+    /* The convolution is done as a matrix product: the input patches of a
+     * tile of output pixels are gathered into rows, and each output value is
+     * the scalar product of a patch with the kernel of its channel. */
     for (int y = thread_param->thread_start; y < thread_param->thread_end; ++y) {
-        for (int x = pad_size; x < width - pad_size; ++x) {
-            for (int n_filter = 0; n_filter < conv_params->output_num; ++n_filter) {
-                if (conv_params->has_bias)
-                    output[n_filter] = conv_params->biases[n_filter];
-                else
-                    output[n_filter] = 0.f;
-
-                for (int ch = 0; ch < conv_params->input_num; ++ch) {
-                    for (int kernel_y = 0; kernel_y < conv_params->kernel_size; ++kernel_y) {
-                        for (int kernel_x = 0; kernel_x < conv_params->kernel_size; ++kernel_x) {
-                            float input_pel;
-                            if (conv_params->padding_method == SAME_CLAMP_TO_EDGE) {
-                                int y_pos = CLAMP_TO_EDGE(y + (kernel_y - radius) * conv_params->dilation, height);
-                                int x_pos = CLAMP_TO_EDGE(x + (kernel_x - radius) * conv_params->dilation, width);
-                                input_pel = input[y_pos * src_linesize + x_pos * conv_params->input_num + ch];
-                            } else {
-                                int y_pos = y + (kernel_y - radius) * conv_params->dilation;
-                                int x_pos = x + (kernel_x - radius) * conv_params->dilation;
-                                input_pel = (x_pos < 0 || x_pos >= width || y_pos < 0 || y_pos >= height) ? 0.0 :
-                                                   input[y_pos * src_linesize + x_pos * conv_params->input_num + ch];
-                            }
-
-
-                            output[n_filter] += input_pel * conv_params->kernel[n_filter * filter_size + kernel_y * filter_linesize +
-                                                                                kernel_x * conv_params->input_num + ch];
-                        }
-                    }
-                }
-                switch (conv_params->activation){
-                case RELU:
-                    output[n_filter] = FFMAX(output[n_filter], 0.0);
-                    break;
-                case TANH:
-                    output[n_filter] = 2.0f  / (1.0f + exp(-2.0f * output[n_filter])) - 1.0f;
-                    break;
-                case SIGMOID:
-                    output[n_filter] = 1.0f / (1.0f + exp(-output[n_filter]));
-                    break;
-                case NONE:
-                    break;
-                case LEAKY_RELU:
-                    output[n_filter] = FFMAX(output[n_filter], 0.0) + 0.2 * FFMIN(output[n_filter], 0.0);
+        for (int x0 = pad_size; x0 < width - pad_size; x0 += PATCH_TILE) {
+            int x1 = FFMIN(x0 + PATCH_TILE, width - pad_size);
+
+            for (int x = x0; x < x1; ++x)
+                gather_patch(patches + (x - x0) * patch_len, input, x, y, width, height, conv_params);
+
+            for (int x = x0; x < x1; ++x) {
+                const float *patch = patches + (x - x0) * patch_len;
+                for (int n_filter = 0; n_filter < conv_params->output_num; ++n_filter) {
+                    float value = fdsp->scalarproduct_float(patch, kernel + n_filter * patch_len, patch_len);
+                    if (conv_params->has_bias)
+                        value += conv_params->biases[n_filter];
+                    output[n_filter] = activate(value, conv_params->activation);
                 }
+                output += conv_params->output_num;
             }
-            output += conv_params->output_num;
         }
     }
     return NULL;
@@ -189,14 +245,17 @@ int ff_dnn_execute_layer_conv2d(DnnOperand *operands, const int32_t *input_opera
 {
 #if HAVE_PTHREAD_CANCEL
     int thread_num = (ctx->options.conv2d_threads <= 0 || ctx->options.conv2d_threads > av_cpu_count())
-        ? (av_cpu_count() + 1) : (ctx->options.conv2d_threads);
+        ? ctx->nb_threads : (ctx->options.conv2d_threads);
     int ret = DNN_SUCCESS, thread_stride;
     ThreadParam *thread_param;
 #else
+    int ret = DNN_SUCCESS;
     ThreadParam thread_param = { 0 };
 #endif
     ThreadCommonParam thread_common_param;
     const ConvolutionalParams *conv_params = parameters;
+    int filter_size = conv_params->kernel_size * conv_params->kernel_size * conv_params->input_num;
+    int patch_len = FFALIGN(filter_size, 16);
     int height = operands[input_operand_indexes[0]].dims[1];
     int width = operands[input_operand_indexes[0]].dims[2];
     int pad_size = (conv_params->padding_method == VALID) ? (conv_params->kernel_size - 1) / 2 * conv_params->dilation : 0;
@@ -225,19 +284,28 @@ int ff_dnn_execute_layer_conv2d(DnnOperand *operands, const int32_t *input_opera
     thread_common_param.output_operand_index = output_operand_index;
     thread_common_param.parameters = parameters;
     thread_common_param.ctx = ctx;
+    thread_common_param.patch_len = patch_len;
 
 #if HAVE_PTHREAD_CANCEL
-    thread_param = av_malloc_array(thread_num, sizeof(*thread_param));
+    thread_num = FFMAX(FFMIN(thread_num, height - pad_size * 2), 1);
+    thread_param = av_mallocz_array(thread_num, sizeof(*thread_param));
     if (!thread_param)
         return DNN_ERROR;
     thread_stride = (height - pad_size * 2) / thread_num;
     //create threads
     for (int i = 0; i < thread_num; i++){
+        thread_param[i].patches = av_calloc(PATCH_TILE, patch_len * sizeof(float));
+        if (!thread_param[i].patches) {
+            thread_num = i;
+            ret = DNN_ERROR;
+            break;
+        }
         thread_param[i].thread_common_param = &thread_common_param;
         thread_param[i].thread_start = thread_stride * i + pad_size;
         thread_param[i].thread_end = (i == thread_num - 1) ? (height - pad_size) : (thread_param[i].thread_start + thread_stride);
         if (pthread_create(&thread_param[i].thread, NULL,
                            dnn_execute_layer_conv2d_thread, &thread_param[i])) {
+            av_freep(&thread_param[i].patches);
             thread_num = i;
             ret = DNN_ERROR;
             break;
@@ -246,18 +314,21 @@ int ff_dnn_execute_layer_conv2d(DnnOperand *operands, const int32_t *input_opera
 
     for (int i = 0; i < thread_num; i++){
         pthread_join(thread_param[i].thread, NULL);
+        av_freep(&thread_param[i].patches);
     }
 
     //release memory
     av_freep(&thread_param);
-
-    return ret;
 #else
+    thread_param.patches = av_calloc(PATCH_TILE, patch_len * sizeof(float));
+    if (!thread_param.patches)
+        return DNN_ERROR;
     thread_param.thread_common_param = &thread_common_param;
     thread_param.thread_start = pad_size;
     thread_param.thread_end = height - pad_size;
     dnn_execute_layer_conv2d_thread(&thread_param);
-
-    return DNN_SUCCESS;
+    av_freep(&thread_param.patches);
 #endif
+
+    return ret;
 }
@@ -21,9 +21,9 @@
 #ifndef AVFILTER_DNN_DNN_BACKEND_NATIVE_LAYER_CONV2D_H
 #define AVFILTER_DNN_DNN_BACKEND_NATIVE_LAYER_CONV2D_H
 
+#include "libavutil/float_dsp.h"
 #include "dnn_backend_native.h"
 
-
 typedef struct ConvolutionalParams{
     int32_t input_num, output_num, kernel_size;
     DNNActivationFunc activation;
@@ -32,8 +32,12 @@ typedef struct ConvolutionalParams{
     int32_t has_bias;
     float *kernel;
     float *biases;
+    /* set up by ff_dnn_init_layer_conv2d() */
+    float *packed_kernel;   ///< kernel of each output channel, zero padded to a multiple of 16
+    AVFloatDSPContext *fdsp;
 } ConvolutionalParams;
 
+int ff_dnn_init_layer_conv2d(ConvolutionalParams *conv_params);
 int ff_dnn_load_layer_conv2d(Layer *layer, AVIOContext *model_file_context, int file_size, int operands_num);
 int ff_dnn_execute_layer_conv2d(DnnOperand *operands, const int32_t *input_operand_indexes,
                                 int32_t output_operand_index, const void *parameters, NativeContext *ctx);
@@ -21,6 +21,29 @@
 #include "libavutil/avassert.h"
 #include "dnn_backend_native_layer_dense.h"
 
+/**
+ * Repack the kernel for the scalar products of the execution, once
+ * per model instead of on every call.
+ */
+int ff_dnn_init_layer_dense(DenseParams *dense_params)
+{
+    int pel_len = FFALIGN(dense_params->input_num, 16);
+
+    dense_params->fdsp = avpriv_float_dsp_alloc(0);
+    dense_params->packed_kernel = av_calloc(dense_params->output_num, pel_len * sizeof(float));
+    if (!dense_params->fdsp || !dense_params->packed_kernel) {
+        av_freep(&dense_params->fdsp);
+        av_freep(&dense_params->packed_kernel);
+        return AVERROR(ENOMEM);
+    }
+    for (int n_filter = 0; n_filter < dense_params->output_num; ++n_filter)
+        memcpy(dense_params->packed_kernel + n_filter * pel_len,
+               dense_params->kernel + n_filter * dense_params->input_num,
+               dense_params->input_num * sizeof(float));
+
+    return 0;
+}
+
 int ff_dnn_load_layer_dense(Layer *layer, AVIOContext *model_file_context, int file_size, int operands_num)
 {
     DenseParams *dense_params;
@@ -69,6 +92,13 @@ int ff_dnn_load_layer_dense(Layer *layer, AVIOContext *model_file_context, int f
         }
     }
 
+    if (ff_dnn_init_layer_dense(dense_params) < 0) {
+        av_freep(&dense_params->biases);
+        av_freep(&dense_params->kernel);
+        av_freep(&dense_params);
+        return 0;
+    }
+
     layer->params = dense_params;
 
     layer->input_operand_indexes[0] = (int32_t)avio_rl32(model_file_context);
@@ -85,7 +115,7 @@ int ff_dnn_load_layer_dense(Layer *layer, AVIOContext *model_file_context, int f
 int ff_dnn_execute_layer_dense(DnnOperand *operands, const int32_t *input_operand_indexes,
                                int32_t output_operand_index, const void *parameters, NativeContext *ctx)
 {
-    float *output;
+    float *output, *pel;
     int32_t input_operand_index = input_operand_indexes[0];
     int number = operands[input_operand_index].dims[0];
     int height = operands[input_operand_index].dims[1];
@@ -93,6 +123,9 @@ int ff_dnn_execute_layer_dense(DnnOperand *operands, const int32_t *input_operan
     int channel = operands[input_operand_index].dims[3];
     const float *input = operands[input_operand_index].data;
     const DenseParams *dense_params = parameters;
+    const AVFloatDSPContext *fdsp = dense_params->fdsp;
+    const float *kernel = dense_params->packed_kernel;
+    int pel_len = FFALIGN(dense_params->input_num, 16);
 
     int src_linesize = width * channel;
     DnnOperand *output_operand = &operands[output_operand_index];
@@ -115,37 +148,44 @@ int ff_dnn_execute_layer_dense(DnnOperand *operands, const int32_t *input_operan
 
     av_assert0(channel == dense_params->input_num);
 
+    /* scalar products need aligned vectors with a length multiple of 16,
+     * so copy every input pixel into a zero padded buffer */
+    pel = av_calloc(pel_len, sizeof(*pel));
+    if (!pel) {
+        av_log(ctx, AV_LOG_ERROR, "Failed to allocate memory for dense layer\n");
+        return DNN_ERROR;
+    }
+
     for (int y = 0; y < height; ++y) {
         for (int x = 0; x < width; ++x) {
+            memcpy(pel, input + y * src_linesize + x * dense_params->input_num,
+                   dense_params->input_num * sizeof(*pel));
             for (int n_filter = 0; n_filter < dense_params->output_num; ++n_filter) {
+                float value = fdsp->scalarproduct_float(pel, kernel + n_filter * pel_len, pel_len);
                 if (dense_params->has_bias)
-                    output[n_filter] = dense_params->biases[n_filter];
-                else
-                    output[n_filter] = 0.f;
-
-                for (int ch = 0; ch < dense_params->input_num; ++ch) {
-                    float input_pel;
-                    input_pel = input[y * src_linesize + x * dense_params->input_num + ch];
-                    output[n_filter] += input_pel * dense_params->kernel[n_filter*dense_params->input_num + ch];
-                }
+                    value += dense_params->biases[n_filter];
+
                 switch (dense_params->activation){
                 case RELU:
-                    output[n_filter] = FFMAX(output[n_filter], 0.0);
+                    value = FFMAX(value, 0.0);
                     break;
                 case TANH:
-                    output[n_filter] = 2.0f  / (1.0f + exp(-2.0f * output[n_filter])) - 1.0f;
+                    value = 2.0f  / (1.0f + exp(-2.0f * value)) - 1.0f;
                     break;
                 case SIGMOID:
-                    output[n_filter] = 1.0f / (1.0f + exp(-output[n_filter]));
+                    value = 1.0f / (1.0f + exp(-value));
                     break;
                 case NONE:
                     break;
                 case LEAKY_RELU:
-                    output[n_filter] = FFMAX(output[n_filter], 0.0) + 0.2 * FFMIN(output[n_filter], 0.0);
+                    value = FFMAX(value, 0.0) + 0.2 * FFMIN(value, 0.0);
                 }
+                output[n_filter] = value;
             }
             output += dense_params->output_num;
         }
     }
+
+    av_freep(&pel);
     return 0;
 }
@@ -21,6 +21,7 @@
 #ifndef AVFILTER_DNN_DNN_BACKEND_NATIVE_LAYER_DENSE_H
 #define AVFILTER_DNN_DNN_BACKEND_NATIVE_LAYER_DENSE_H
 
+#include "libavutil/float_dsp.h"
 #include "dnn_backend_native.h"
 
 typedef struct DenseParams{
@@ -29,8 +30,12 @@ typedef struct DenseParams{
     int32_t has_bias;
     float *kernel;
     float *biases;
+    /* set up by ff_dnn_init_layer_dense() */
+    float *packed_kernel;   ///< kernel of each output channel, zero padded to a multiple of 16
+    AVFloatDSPContext *fdsp;
 } DenseParams;
 
+int ff_dnn_init_layer_dense(DenseParams *dense_params);
 int ff_dnn_load_layer_dense(Layer *layer, AVIOContext *model_file_context, int file_size, int operands_num);
 int ff_dnn_execute_layer_dense(DnnOperand *operands, const int32_t *input_operand_indexes,
                                int32_t output_operand_index, const void *parameters, NativeContext *ctx);
@@ -90,6 +90,10 @@ struct FFEBUR128StateInternal {
     unsigned long *short_term_block_energy_histogram;
     /** Keeps track of when a new short term block is needed. */
     size_t short_term_frame_counter;
+    /** Channel weighted energy of each 100ms segment of audio_data, so that
+     *  overlapping gating and short term blocks do not sum the same samples
+     *  over and over. */
+    double *segment_energy;
     /** Maximum sample peak, one per channel */
     double *sample_peak;
     /** The maximum window duration in ms. */
@@ -257,6 +261,11 @@ FFEBUR128State *ff_ebur128_init(unsigned int channels,
                                     st->channels * sizeof(*st->d->audio_data));
     CHECK_ERROR(!st->d->audio_data, 0, free_sample_peak)
 
+    st->d->segment_energy =
+        (double *) av_mallocz_array(st->d->audio_data_frames / st->d->samples_in_100ms,
+                                    sizeof(*st->d->segment_energy));
+    CHECK_ERROR(!st->d->segment_energy, 0, free_audio_data)
+
     ebur128_init_filter(st);
 
     st->d->block_energy_histogram =
@@ -287,6 +296,7 @@ free_short_term_block_energy_histogram:
 free_block_energy_histogram:
     av_free(st->d->block_energy_histogram);
 free_audio_data:
+    av_free(st->d->segment_energy);
     av_free(st->d->audio_data);
 free_sample_peak:
     av_free(st->d->sample_peak);
@@ -305,6 +315,7 @@ void ff_ebur128_destroy(FFEBUR128State ** st)
     av_free((*st)->d->block_energy_histogram);
     av_free((*st)->d->short_term_block_energy_histogram);
     av_free((*st)->d->audio_data);
+    av_free((*st)->d->segment_energy);
     av_free((*st)->d->channel_map);
     av_free((*st)->d->sample_peak);
     av_free((*st)->d->data_ptrs);
@@ -336,30 +347,35 @@ static void ebur128_filter_##type(FFEBUR128State* st, const type** srcs,
         }                                                                          \
     }                                                                              \
     for (c = 0; c < st->channels; ++c) {                                           \
+        const type *src = srcs[c] + src_index;                                     \
+        double *dst = audio_data + c;                                              \
+        const double b0 = st->d->b[0], b1 = st->d->b[1], b2 = st->d->b[2];         \
+        const double b3 = st->d->b[3], b4 = st->d->b[4];                           \
+        const double a1 = st->d->a[1], a2 = st->d->a[2];                           \
+        const double a3 = st->d->a[3], a4 = st->d->a[4];                           \
+        double v1, v2, v3, v4;                                                     \
         int ci = st->d->channel_map[c] - 1;                                        \
         if (ci < 0) continue;                                                      \
         else if (ci == FF_EBUR128_DUAL_MONO - 1) ci = 0; /*dual mono */            \
+        /* keep the filter state in registers rather than in the context */       \
+        v1 = st->d->v[ci][1];                                                      \
+        v2 = st->d->v[ci][2];                                                      \
+        v3 = st->d->v[ci][3];                                                      \
+        v4 = st->d->v[ci][4];                                                      \
         for (i = 0; i < frames; ++i) {                                             \
-            st->d->v[ci][0] = (double) (srcs[c][src_index + i * stride] / scaling_factor) \
-                         - st->d->a[1] * st->d->v[ci][1]                           \
-                         - st->d->a[2] * st->d->v[ci][2]                           \
-                         - st->d->a[3] * st->d->v[ci][3]                           \
-                         - st->d->a[4] * st->d->v[ci][4];                          \
-            audio_data[i * st->channels + c] =                                     \
-                           st->d->b[0] * st->d->v[ci][0]                           \
-                         + st->d->b[1] * st->d->v[ci][1]                           \
-                         + st->d->b[2] * st->d->v[ci][2]                           \
-                         + st->d->b[3] * st->d->v[ci][3]                           \
-                         + st->d->b[4] * st->d->v[ci][4];                          \
-            st->d->v[ci][4] = st->d->v[ci][3];                                     \
-            st->d->v[ci][3] = st->d->v[ci][2];                                     \
-            st->d->v[ci][2] = st->d->v[ci][1];                                     \
-            st->d->v[ci][1] = st->d->v[ci][0];                                     \
+            double v0 = (double) (src[i * stride] / scaling_factor)                \
+                         - a1 * v1 - a2 * v2 - a3 * v3 - a4 * v4;                  \
+            dst[i * st->channels] = b0 * v0 + b1 * v1 + b2 * v2                    \
+                                  + b3 * v3 + b4 * v4;                             \
+            v4 = v3;                                                               \
+            v3 = v2;                                                               \
+            v2 = v1;                                                               \
+            v1 = v0;                                                               \
         }                                                                          \
-        st->d->v[ci][4] = fabs(st->d->v[ci][4]) < DBL_MIN ? 0.0 : st->d->v[ci][4]; \
-        st->d->v[ci][3] = fabs(st->d->v[ci][3]) < DBL_MIN ? 0.0 : st->d->v[ci][3]; \
-        st->d->v[ci][2] = fabs(st->d->v[ci][2]) < DBL_MIN ? 0.0 : st->d->v[ci][2]; \
-        st->d->v[ci][1] = fabs(st->d->v[ci][1]) < DBL_MIN ? 0.0 : st->d->v[ci][1]; \
+        st->d->v[ci][4] = fabs(v4) < DBL_MIN ? 0.0 : v4;                           \
+        st->d->v[ci][3] = fabs(v3) < DBL_MIN ? 0.0 : v3;                           \
+        st->d->v[ci][2] = fabs(v2) < DBL_MIN ? 0.0 : v2;                           \
+        st->d->v[ci][1] = fabs(v1) < DBL_MIN ? 0.0 : v1;                           \
     }                                                                              \
 }
 EBUR128_FILTER(double, 1.0)
@@ -387,6 +403,69 @@ static size_t find_histogram_index(double energy)
     return index_min;
 }
 
+static double ebur128_channel_weight(FFEBUR128State * st, size_t c)
+{
+    switch (st->d->channel_map[c]) {
+    case FF_EBUR128_UNUSED:
+        return 0.0;
+    case FF_EBUR128_Mp110:
+    case FF_EBUR128_Mm110:
+    case FF_EBUR128_Mp060:
+    case FF_EBUR128_Mm060:
+    case FF_EBUR128_Mp090:
+    case FF_EBUR128_Mm090:
+        return 1.41;
+    case FF_EBUR128_DUAL_MONO:
+        return 2.0;
+    default:
+        return 1.0;
+    }
+}
+
+/**
+ * Compute the energy of the 100ms segments of audio_data that were completed
+ * by writing the frames from start to end.
+ */
+static void ebur128_calc_segments(FFEBUR128State * st, size_t start, size_t end)
+{
+    const size_t segment_frames = st->d->samples_in_100ms;
+    size_t segment, i, c;
+
+    for (segment = start / segment_frames; segment < end / segment_frames; segment++) {
+        const double *data = st->d->audio_data + segment * segment_frames * st->channels;
+        double sum = 0.0;
+
+        for (c = 0; c < st->channels; ++c) {
+            double weight = ebur128_channel_weight(st, c);
+            double channel_sum = 0.0;
+
+            if (weight == 0.0)
+                continue;
+            for (i = 0; i < segment_frames; ++i)
+                channel_sum += data[i * st->channels + c] * data[i * st->channels + c];
+            sum += channel_sum * weight;
+        }
+        st->d->segment_energy[segment] = sum;
+    }
+}
+
+/**
+ * Sum the energy of the last nb_segments completed 100ms segments. Only valid
+ * when audio_data_index is on a segment boundary.
+ */
+static double ebur128_segments_energy(FFEBUR128State * st, size_t nb_segments)
+{
+    const size_t total_segments = st->d->audio_data_frames / st->d->samples_in_100ms;
+    size_t end = st->d->audio_data_index / st->channels / st->d->samples_in_100ms;
+    double sum = 0.0;
+    size_t n;
+
+    for (n = 0; n < nb_segments; n++)
+        sum += st->d->segment_energy[(end + total_segments - 1 - n) % total_segments];
+
+    return sum;
+}
+
 static void ebur128_calc_gating_block(FFEBUR128State * st,
                                       size_t frames_per_block,
                                       double *optional_output)
@@ -394,6 +473,13 @@ static void ebur128_calc_gating_block(FFEBUR128State * st,
     size_t i, c;
     double sum = 0.0;
     double channel_sum;
+
+    if ((st->d->audio_data_index / st->channels) % st->d->samples_in_100ms == 0 &&
+        frames_per_block % st->d->samples_in_100ms == 0) {
+        sum = ebur128_segments_energy(st, frames_per_block / st->d->samples_in_100ms);
+        goto done;
+    }
+
     for (c = 0; c < st->channels; ++c) {
         if (st->d->channel_map[c] == FF_EBUR128_UNUSED)
             continue;
@@ -433,6 +519,7 @@ static void ebur128_calc_gating_block(FFEBUR128State * st,
         }
         sum += channel_sum;
     }
+done:
     sum /= (double) frames_per_block;
     if (optional_output) {
         *optional_output = sum;
@@ -462,16 +549,21 @@ static void ebur128_add_frames_planar_##type(FFEBUR128State* st, const type** sr
     size_t src_index = 0;                                                              \
     while (frames > 0) {                                                               \
         if (frames >= st->d->needed_frames) {                                          \
+            size_t block_frames = st->d->needed_frames;                                \
+            size_t start = st->d->audio_data_index / st->channels;                     \
             ebur128_filter_##type(st, srcs, src_index, st->d->needed_frames, stride);  \
             src_index += st->d->needed_frames * stride;                                \
             frames -= st->d->needed_frames;                                            \
             st->d->audio_data_index += st->d->needed_frames * st->channels;            \
+            ebur128_calc_segments(st, start, start + block_frames);                    \
+            /* 100ms are needed for all blocks besides the first one */                \
+            st->d->needed_frames = st->d->samples_in_100ms;                            \
             /* calculate the new gating block */                                       \
             if ((st->mode & FF_EBUR128_MODE_I) == FF_EBUR128_MODE_I) {                 \
                 ebur128_calc_gating_block(st, st->d->samples_in_100ms * 4, NULL);      \
             }                                                                          \
             if ((st->mode & FF_EBUR128_MODE_LRA) == FF_EBUR128_MODE_LRA) {             \
-                st->d->short_term_frame_counter += st->d->needed_frames;               \
+                st->d->short_term_frame_counter += block_frames;                       \
                 if (st->d->short_term_frame_counter == st->d->samples_in_100ms * 30) { \
                     double st_energy;                                                  \
                     ebur128_energy_shortterm(st, &st_energy);                          \
@@ -482,15 +574,15 @@ static void ebur128_add_frames_planar_##type(FFEBUR128State* st, const type** sr
                     st->d->short_term_frame_counter = st->d->samples_in_100ms * 20;    \
                 }                                                                      \
             }                                                                          \
-            /* 100ms are needed for all blocks besides the first one */                \
-            st->d->needed_frames = st->d->samples_in_100ms;                            \
             /* reset audio_data_index when buffer full */                              \
             if (st->d->audio_data_index == st->d->audio_data_frames * st->channels) {  \
                 st->d->audio_data_index = 0;                                           \
             }                                                                          \
         } else {                                                                       \
+            size_t start = st->d->audio_data_index / st->channels;                     \
             ebur128_filter_##type(st, srcs, src_index, frames, stride);                \
             st->d->audio_data_index += frames * st->channels;                          \
+            ebur128_calc_segments(st, start, start + frames);                          \
             if ((st->mode & FF_EBUR128_MODE_LRA) == FF_EBUR128_MODE_LRA) {             \
                 st->d->short_term_frame_counter += frames;                             \
             }                                                                          \
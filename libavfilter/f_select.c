@@ -154,6 +154,8 @@ typedef struct SelectContext {
     ff_scene_sad_fn sad;            ///< Sum of the absolute difference function (scene detect only)
     double prev_mafd;               ///< previous MAFD                           (scene detect only)
     AVFrame *prev_picref;           ///< previous frame                          (scene detect only)
+    int nb_threads;
+    uint64_t *thread_sad;           ///< per-slice SAD                           (scene detect only)
     double select;
     int select_out;                 ///< mark the selected output pad index
     int nb_outputs;
@@ -266,10 +268,44 @@ static int config_input(AVFilterLink *inlink)
         select->sad = ff_scene_sad_get_fn(select->bitdepth == 8 ? 8 : 16);
         if (!select->sad)
             return AVERROR(EINVAL);
+
+        select->nb_threads = ff_filter_get_nb_threads(inlink->dst);
+        select->thread_sad = av_calloc(select->nb_threads, sizeof(*select->thread_sad));
+        if (!select->thread_sad)
+            return AVERROR(ENOMEM);
     }
     return 0;
 }
 
+typedef struct ThreadData {
+    AVFrame *prev, *cur;
+} ThreadData;
+
+static int scene_sad_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    SelectContext *select = ctx->priv;
+    ThreadData *td = arg;
+    uint64_t sad = 0;
+
+    for (int plane = 0; plane < select->nb_planes; plane++) {
+        const int slice_start = (select->height[plane] * jobnr) / nb_jobs;
+        const int slice_end = (select->height[plane] * (jobnr+1)) / nb_jobs;
+        uint64_t plane_sad;
+
+        if (slice_start == slice_end)
+            continue;
+        select->sad(td->prev->data[plane] + slice_start * td->prev->linesize[plane],
+                    td->prev->linesize[plane],
+                    td->cur->data[plane] + slice_start * td->cur->linesize[plane],
+                    td->cur->linesize[plane],
+                    select->width[plane], slice_end - slice_start, &plane_sad);
+        sad += plane_sad;
+    }
+    select->thread_sad[jobnr] = sad;
+
+    return 0;
+}
+
 static double get_scene_score(AVFilterContext *ctx, AVFrame *frame)
 {
     double ret = 0;
@@ -279,18 +315,17 @@ static double get_scene_score(AVFilterContext *ctx, AVFrame *frame)
     if (prev_picref &&
         frame->height == prev_picref->height &&
         frame->width  == prev_picref->width) {
+        const int nb_jobs = FFMIN(select->height[0], select->nb_threads);
+        ThreadData td = { .prev = prev_picref, .cur = frame };
         uint64_t sad = 0;
         double mafd, diff;
         uint64_t count = 0;
 
-        for (int plane = 0; plane < select->nb_planes; plane++) {
-            uint64_t plane_sad;
-            select->sad(prev_picref->data[plane], prev_picref->linesize[plane],
-                    frame->data[plane], frame->linesize[plane],
-                    select->width[plane], select->height[plane], &plane_sad);
-            sad += plane_sad;
+        ctx->internal->execute(ctx, scene_sad_slice, &td, NULL, nb_jobs);
+        for (int i = 0; i < nb_jobs; i++)
+            sad += select->thread_sad[i];
+        for (int plane = 0; plane < select->nb_planes; plane++)
             count += select->width[plane] * select->height[plane];
-        }
 
         emms_c();
         mafd = (double)sad / count / (1ULL << (select->bitdepth - 8));
@@ -442,6 +477,7 @@ static av_cold void uninit(AVFilterContext *ctx)
 
     if (select->do_scene_detect) {
         av_frame_free(&select->prev_picref);
+        av_freep(&select->thread_sad);
     }
 }
 
@@ -549,6 +585,6 @@ AVFilter ff_vf_select = {
     .priv_size     = sizeof(SelectContext),
     .priv_class    = &select_class,
     .inputs        = avfilter_vf_select_inputs,
-    .flags         = AVFILTER_FLAG_DYNAMIC_OUTPUTS,
+    .flags         = AVFILTER_FLAG_DYNAMIC_OUTPUTS | AVFILTER_FLAG_SLICE_THREADS,
 };
 #endif /* CONFIG_SELECT_FILTER */
@@ -144,6 +144,7 @@ typedef struct V360Context {
     int ih_flip, iv_flip;
     int h_flip, v_flip, d_flip;
     int in_transpose, out_transpose;
+    int lazy;
 
     float h_fov, v_fov, d_fov;
     float ih_fov, iv_fov, id_fov;
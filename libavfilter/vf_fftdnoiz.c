@@ -23,8 +23,8 @@
 #include "libavutil/imgutils.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
+#include "libavutil/tx.h"
 #include "internal.h"
-#include "libavcodec/avfft.h"
 
 enum BufferTypes {
     CURRENT,
@@ -41,11 +41,7 @@ typedef struct PlaneContext {
     float n;
 
     float *buffer[BSIZE];
-    FFTComplex *hdata, *vdata;
-    int data_linesize;
     int buffer_linesize;
-
-    FFTContext *fft, *ifft;
 } PlaneContext;
 
 typedef struct FFTdnoizContext {
@@ -63,10 +59,17 @@ typedef struct FFTdnoizContext {
 
     int depth;
     int nb_planes;
+    int nb_threads;
     PlaneContext planes[4];
 
-    void (*import_row)(FFTComplex *dst, uint8_t *src, int rw);
-    void (*export_row)(FFTComplex *src, uint8_t *dst, int rw, float scale, int depth);
+    /* per-thread transform contexts and scratch blocks */
+    AVComplexFloat **hdata, **vdata;
+    int data_linesize;
+    AVTXContext **fft, **ifft;
+    av_tx_fn tx_fn, itx_fn;
+
+    void (*import_row)(AVComplexFloat *dst, uint8_t *src, int rw);
+    void (*export_row)(AVComplexFloat *src, uint8_t *dst, int rw, float scale, int depth);
 } FFTdnoizContext;
 
 #define OFFSET(x) offsetof(FFTdnoizContext, x)
@@ -91,23 +94,6 @@ static const AVOption fftdnoiz_options[] = {
 
 AVFILTER_DEFINE_CLASS(fftdnoiz);
 
-static av_cold int init(AVFilterContext *ctx)
-{
-    FFTdnoizContext *s = ctx->priv;
-    int i;
-
-    for (i = 0; i < 4; i++) {
-        PlaneContext *p = &s->planes[i];
-
-        p->fft  = av_fft_init(s->block_bits, 0);
-        p->ifft = av_fft_init(s->block_bits, 1);
-        if (!p->fft || !p->ifft)
-            return AVERROR(ENOMEM);
-    }
-
-    return 0;
-}
-
 static int query_formats(AVFilterContext *ctx)
 {
     static const enum AVPixelFormat pix_fmts[] = {
@@ -143,10 +129,11 @@ static int query_formats(AVFilterContext *ctx)
 }
 
 typedef struct ThreadData {
-    float *src, *dst;
+    AVFrame *out;
+    int plane;
 } ThreadData;
 
-static void import_row8(FFTComplex *dst, uint8_t *src, int rw)
+static void import_row8(AVComplexFloat *dst, uint8_t *src, int rw)
 {
     int j;
 
@@ -156,7 +143,7 @@ static void import_row8(FFTComplex *dst, uint8_t *src, int rw)
     }
 }
 
-static void export_row8(FFTComplex *src, uint8_t *dst, int rw, float scale, int depth)
+static void export_row8(AVComplexFloat *src, uint8_t *dst, int rw, float scale, int depth)
 {
     int j;
 
@@ -164,7 +151,7 @@ static void export_row8(FFTComplex *src, uint8_t *dst, int rw, float scale, int
         dst[j] = av_clip_uint8(src[j].re * scale + 0.5f);
 }
 
-static void import_row16(FFTComplex *dst, uint8_t *srcp, int rw)
+static void import_row16(AVComplexFloat *dst, uint8_t *srcp, int rw)
 {
     uint16_t *src = (uint16_t *)srcp;
     int j;
@@ -175,7 +162,7 @@ static void import_row16(FFTComplex *dst, uint8_t *srcp, int rw)
     }
 }
 
-static void export_row16(FFTComplex *src, uint8_t *dstp, int rw, float scale, int depth)
+static void export_row16(AVComplexFloat *src, uint8_t *dstp, int rw, float scale, int depth)
 {
     uint16_t *dst = (uint16_t *)dstp;
     int j;
@@ -189,7 +176,8 @@ static int config_input(AVFilterLink *inlink)
     AVFilterContext *ctx = inlink->dst;
     const AVPixFmtDescriptor *desc;
     FFTdnoizContext *s = ctx->priv;
-    int i;
+    float scale = 1.f;
+    int i, ret;
 
     desc = av_pix_fmt_desc_get(inlink->format);
     s->depth = desc->comp[0].depth;
@@ -223,7 +211,7 @@ static int config_input(AVFilterLink *inlink)
 
         av_log(ctx, AV_LOG_DEBUG, "nox:%d noy:%d size:%d\n", p->nox, p->noy, size);
 
-        p->buffer_linesize = p->b * p->nox * sizeof(FFTComplex);
+        p->buffer_linesize = p->b * p->nox * sizeof(AVComplexFloat);
         p->buffer[CURRENT] = av_calloc(p->b * p->noy, p->buffer_linesize);
         if (!p->buffer[CURRENT])
             return AVERROR(ENOMEM);
@@ -237,11 +225,32 @@ static int config_input(AVFilterLink *inlink)
             if (!p->buffer[NEXT])
                 return AVERROR(ENOMEM);
         }
-        p->data_linesize = 2 * p->b * sizeof(float);
-        p->hdata = av_calloc(p->b, p->data_linesize);
-        p->vdata = av_calloc(p->b, p->data_linesize);
-        if (!p->hdata || !p->vdata)
+    }
+
+    s->nb_threads = ff_filter_get_nb_threads(ctx);
+    s->data_linesize = 2 * (1 << s->block_bits) * sizeof(float);
+    s->hdata = av_calloc(s->nb_threads, sizeof(*s->hdata));
+    s->vdata = av_calloc(s->nb_threads, sizeof(*s->vdata));
+    s->fft   = av_calloc(s->nb_threads, sizeof(*s->fft));
+    s->ifft  = av_calloc(s->nb_threads, sizeof(*s->ifft));
+    if (!s->hdata || !s->vdata || !s->fft || !s->ifft)
+        return AVERROR(ENOMEM);
+
+    for (i = 0; i < s->nb_threads; i++) {
+        s->hdata[i] = av_calloc(1 << s->block_bits, s->data_linesize);
+        s->vdata[i] = av_calloc(1 << s->block_bits, s->data_linesize);
+        if (!s->hdata[i] || !s->vdata[i])
             return AVERROR(ENOMEM);
+
+        ret = av_tx_init(&s->fft[i], &s->tx_fn, AV_TX_FLOAT_FFT, 0,
+                         1 << s->block_bits, &scale, AV_TX_INPLACE);
+        if (ret < 0)
+            return ret;
+
+        ret = av_tx_init(&s->ifft[i], &s->itx_fn, AV_TX_FLOAT_FFT, 1,
+                         1 << s->block_bits, &scale, AV_TX_INPLACE);
+        if (ret < 0)
+            return ret;
     }
 
     return 0;
@@ -249,7 +258,8 @@ static int config_input(AVFilterLink *inlink)
 
 static void import_plane(FFTdnoizContext *s,
                          uint8_t *srcp, int src_linesize,
-                         float *buffer, int buffer_linesize, int plane)
+                         float *buffer, int buffer_linesize, int plane,
+                         int slice_start, int slice_end, int jobnr)
 {
     PlaneContext *p = &s->planes[plane];
     const int width = p->planewidth;
@@ -258,41 +268,39 @@ static void import_plane(FFTdnoizContext *s,
     const int overlap = p->o;
     const int size = block - overlap;
     const int nox = p->nox;
-    const int noy = p->noy;
     const int bpp = (s->depth + 7) / 8;
-    const int data_linesize = p->data_linesize / sizeof(FFTComplex);
-    FFTComplex *hdata = p->hdata;
-    FFTComplex *vdata = p->vdata;
+    const int data_linesize = s->data_linesize / sizeof(AVComplexFloat);
+    AVComplexFloat *hdata = s->hdata[jobnr];
+    AVComplexFloat *vdata = s->vdata[jobnr];
+    AVTXContext *fft = s->fft[jobnr];
     int x, y, i, j;
 
     buffer_linesize /= sizeof(float);
-    for (y = 0; y < noy; y++) {
+    for (y = slice_start; y < slice_end; y++) {
         for (x = 0; x < nox; x++) {
             const int rh = FFMIN(block, height - y * size);
             const int rw = FFMIN(block, width  - x * size);
             uint8_t *src = srcp + src_linesize * y * size + x * size * bpp;
             float *bdst = buffer + buffer_linesize * y * block + x * block * 2;
-            FFTComplex *ssrc, *dst = hdata;
+            AVComplexFloat *ssrc, *dst = hdata;
 
             for (i = 0; i < rh; i++) {
                 s->import_row(dst, src, rw);
                 for (j = rw; j < block; j++) {
-                    dst[j].re = dst[block - j - 1].re;
+                    dst[j].re = dst[FFMIN(block - j - 1, rw - 1)].re;
                     dst[j].im = 0;
                 }
-                av_fft_permute(p->fft, dst);
-                av_fft_calc(p->fft, dst);
+                s->tx_fn(fft, dst, dst, sizeof(float));
 
                 src += src_linesize;
                 dst += data_linesize;
             }
 
-            dst = hdata;
             for (; i < block; i++) {
-                for (j = 0; j < block; j++) {
-                    dst[j].re = dst[(block - i - 1) * data_linesize + j].re;
-                    dst[j].im = dst[(block - i - 1) * data_linesize + j].im;
-                }
+                const int k = FFMIN(block - i - 1, rh - 1);
+
+                memcpy(dst, hdata + k * data_linesize, block * sizeof(AVComplexFloat));
+                dst += data_linesize;
             }
 
             ssrc = hdata;
@@ -300,9 +308,8 @@ static void import_plane(FFTdnoizContext *s,
             for (i = 0; i < block; i++) {
                 for (j = 0; j < block; j++)
                     dst[j] = ssrc[j * data_linesize + i];
-                av_fft_permute(p->fft, dst);
-                av_fft_calc(p->fft, dst);
-                memcpy(bdst, dst, block * sizeof(FFTComplex));
+                s->tx_fn(fft, dst, dst, sizeof(float));
+                memcpy(bdst, dst, block * sizeof(AVComplexFloat));
 
                 dst += data_linesize;
                 bdst += buffer_linesize;
@@ -313,7 +320,8 @@ static void import_plane(FFTdnoizContext *s,
 
 static void export_plane(FFTdnoizContext *s,
                          uint8_t *dstp, int dst_linesize,
-                         float *buffer, int buffer_linesize, int plane)
+                         float *buffer, int buffer_linesize, int plane,
+                         int slice_start, int slice_end, int jobnr)
 {
     PlaneContext *p = &s->planes[plane];
     const int depth = s->depth;
@@ -326,28 +334,31 @@ static void export_plane(FFTdnoizContext *s,
     const int size = block - overlap;
     const int nox = p->nox;
     const int noy = p->noy;
-    const int data_linesize = p->data_linesize / sizeof(FFTComplex);
+    const int data_linesize = s->data_linesize / sizeof(AVComplexFloat);
     const float scale = 1.f / (block * block);
-    FFTComplex *hdata = p->hdata;
-    FFTComplex *vdata = p->vdata;
+    AVComplexFloat *hdata = s->hdata[jobnr];
+    AVComplexFloat *vdata = s->vdata[jobnr];
+    AVTXContext *ifft = s->ifft[jobnr];
     int x, y, i, j;
 
     buffer_linesize /= sizeof(float);
-    for (y = 0; y < noy; y++) {
+    for (y = slice_start; y < slice_end; y++) {
         for (x = 0; x < nox; x++) {
             const int woff = x == 0 ? 0 : hoverlap;
             const int hoff = y == 0 ? 0 : hoverlap;
             const int rw = x == 0 ? block : FFMIN(size, width  - x * size - woff);
-            const int rh = y == 0 ? block : FFMIN(size, height - y * size - hoff);
+            /* stop where the next block row starts writing, so that block
+             * rows never touch the same output lines */
+            const int rh = y == 0 ? (noy > 1 ? size + hoverlap : block)
+                                  : FFMIN(size, height - y * size - hoff);
             float *bsrc = buffer + buffer_linesize * y * block + x * block * 2;
             uint8_t *dst = dstp + dst_linesize * (y * size + hoff) + (x * size + woff) * bpp;
-            FFTComplex *hdst, *ddst = vdata;
+            AVComplexFloat *hdst, *ddst = vdata;
 
             hdst = hdata;
             for (i = 0; i < block; i++) {
-                memcpy(ddst, bsrc, block * sizeof(FFTComplex));
-                av_fft_permute(p->ifft, ddst);
-                av_fft_calc(p->ifft, ddst);
+                memcpy(ddst, bsrc, block * sizeof(AVComplexFloat));
+                s->itx_fn(ifft, ddst, ddst, sizeof(float));
                 for (j = 0; j < block; j++) {
                     hdst[j * data_linesize + i] = ddst[j];
                 }
@@ -358,8 +369,7 @@ static void export_plane(FFTdnoizContext *s,
 
             hdst = hdata + hoff * data_linesize;
             for (i = 0; i < rh; i++) {
-                av_fft_permute(p->ifft, hdst);
-                av_fft_calc(p->ifft, hdst);
+                s->itx_fn(ifft, hdst, hdst, sizeof(float));
                 s->export_row(hdst + woff, dst, rw, scale, depth);
 
                 hdst += data_linesize;
@@ -369,12 +379,12 @@ static void export_plane(FFTdnoizContext *s,
     }
 }
 
-static void filter_plane3d2(FFTdnoizContext *s, int plane, float *pbuffer, float *nbuffer)
+static void filter_plane3d2(FFTdnoizContext *s, int plane, float *pbuffer, float *nbuffer,
+                            int slice_start, int slice_end)
 {
     PlaneContext *p = &s->planes[plane];
     const int block = p->b;
     const int nox = p->nox;
-    const int noy = p->noy;
     const int buffer_linesize = p->buffer_linesize / sizeof(float);
     const float sigma = s->sigma * s->sigma * block * block;
     const float limit = 1.f - s->amount;
@@ -383,7 +393,7 @@ static void filter_plane3d2(FFTdnoizContext *s, int plane, float *pbuffer, float
     const float scale = 1.f / 3.f;
     int y, x, i, j;
 
-    for (y = 0; y < noy; y++) {
+    for (y = slice_start; y < slice_end; y++) {
         for (x = 0; x < nox; x++) {
             float *cbuff = cbuffer + buffer_linesize * y * block + x * block * 2;
             float *pbuff = pbuffer + buffer_linesize * y * block + x * block * 2;
@@ -429,19 +439,19 @@ static void filter_plane3d2(FFTdnoizContext *s, int plane, float *pbuffer, float
     }
 }
 
-static void filter_plane3d1(FFTdnoizContext *s, int plane, float *pbuffer)
+static void filter_plane3d1(FFTdnoizContext *s, int plane, float *pbuffer,
+                            int slice_start, int slice_end)
 {
     PlaneContext *p = &s->planes[plane];
     const int block = p->b;
     const int nox = p->nox;
-    const int noy = p->noy;
     const int buffer_linesize = p->buffer_linesize / sizeof(float);
     const float sigma = s->sigma * s->sigma * block * block;
     const float limit = 1.f - s->amount;
     float *cbuffer = p->buffer[CURRENT];
     int y, x, i, j;
 
-    for (y = 0; y < noy; y++) {
+    for (y = slice_start; y < slice_end; y++) {
         for (x = 0; x < nox; x++) {
             float *cbuff = cbuffer + buffer_linesize * y * block + x * block * 2;
             float *pbuff = pbuffer + buffer_linesize * y * block + x * block * 2;
@@ -481,19 +491,19 @@ static void filter_plane3d1(FFTdnoizContext *s, int plane, float *pbuffer)
     }
 }
 
-static void filter_plane2d(FFTdnoizContext *s, int plane)
+static void filter_plane2d(FFTdnoizContext *s, int plane,
+                           int slice_start, int slice_end)
 {
     PlaneContext *p = &s->planes[plane];
     const int block = p->b;
     const int nox = p->nox;
-    const int noy = p->noy;
     const int buffer_linesize = p->buffer_linesize / 4;
     const float sigma = s->sigma * s->sigma * block * block;
     const float limit = 1.f - s->amount;
     float *buffer = p->buffer[CURRENT];
     int y, x, i, j;
 
-    for (y = 0; y < noy; y++) {
+    for (y = slice_start; y < slice_end; y++) {
         for (x = 0; x < nox; x++) {
             float *buff = buffer + buffer_linesize * y * block + x * block * 2;
 
@@ -515,12 +525,68 @@ static void filter_plane2d(FFTdnoizContext *s, int plane)
     }
 }
 
+static int denoise_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    FFTdnoizContext *s = ctx->priv;
+    ThreadData *td = arg;
+    const int plane = td->plane;
+    PlaneContext *p = &s->planes[plane];
+    const int slice_start = (p->noy * jobnr) / nb_jobs;
+    const int slice_end = (p->noy * (jobnr+1)) / nb_jobs;
+
+    /* rows of blocks are transformed and filtered independently */
+    if (s->next) {
+        import_plane(s, s->next->data[plane], s->next->linesize[plane],
+                     p->buffer[NEXT], p->buffer_linesize, plane,
+                     slice_start, slice_end, jobnr);
+    }
+
+    if (s->prev) {
+        import_plane(s, s->prev->data[plane], s->prev->linesize[plane],
+                     p->buffer[PREV], p->buffer_linesize, plane,
+                     slice_start, slice_end, jobnr);
+    }
+
+    import_plane(s, s->cur->data[plane], s->cur->linesize[plane],
+                 p->buffer[CURRENT], p->buffer_linesize, plane,
+                 slice_start, slice_end, jobnr);
+
+    if (s->next && s->prev) {
+        filter_plane3d2(s, plane, p->buffer[PREV], p->buffer[NEXT], slice_start, slice_end);
+    } else if (s->next) {
+        filter_plane3d1(s, plane, p->buffer[NEXT], slice_start, slice_end);
+    } else  if (s->prev) {
+        filter_plane3d1(s, plane, p->buffer[PREV], slice_start, slice_end);
+    } else {
+        filter_plane2d(s, plane, slice_start, slice_end);
+    }
+
+    return 0;
+}
+
+static int export_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    FFTdnoizContext *s = ctx->priv;
+    ThreadData *td = arg;
+    const int plane = td->plane;
+    PlaneContext *p = &s->planes[plane];
+    const int slice_start = (p->noy * jobnr) / nb_jobs;
+    const int slice_end = (p->noy * (jobnr+1)) / nb_jobs;
+
+    export_plane(s, td->out->data[plane], td->out->linesize[plane],
+                 p->buffer[CURRENT], p->buffer_linesize, plane,
+                 slice_start, slice_end, jobnr);
+
+    return 0;
+}
+
 static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
     AVFilterContext *ctx = inlink->dst;
     FFTdnoizContext *s = ctx->priv;
     AVFilterLink *outlink = ctx->outputs[0];
     int direct, plane;
+    ThreadData td;
     AVFrame *out;
 
     if (s->nb_next > 0 && s->nb_prev > 0) {
@@ -578,31 +644,13 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
             continue;
         }
 
-        if (s->next) {
-            import_plane(s, s->next->data[plane], s->next->linesize[plane],
-                         p->buffer[NEXT], p->buffer_linesize, plane);
-        }
-
-        if (s->prev) {
-            import_plane(s, s->prev->data[plane], s->prev->linesize[plane],
-                         p->buffer[PREV], p->buffer_linesize, plane);
-        }
-
-        import_plane(s, s->cur->data[plane], s->cur->linesize[plane],
-                     p->buffer[CURRENT], p->buffer_linesize, plane);
-
-        if (s->next && s->prev) {
-            filter_plane3d2(s, plane, p->buffer[PREV], p->buffer[NEXT]);
-        } else if (s->next) {
-            filter_plane3d1(s, plane, p->buffer[NEXT]);
-        } else  if (s->prev) {
-            filter_plane3d1(s, plane, p->buffer[PREV]);
-        } else {
-            filter_plane2d(s, plane);
-        }
-
-        export_plane(s, out->data[plane], out->linesize[plane],
-                     p->buffer[CURRENT], p->buffer_linesize, plane);
+        td.out = out;
+        td.plane = plane;
+        ctx->internal->execute(ctx, denoise_slice, &td, NULL,
+                               FFMIN(p->noy, s->nb_threads));
+        /* separate pass: blocks overlap, and the output may be the input */
+        ctx->internal->execute(ctx, export_slice, &td, NULL,
+                               FFMIN(p->noy, s->nb_threads));
     }
 
     if (s->nb_next == 0 && s->nb_prev == 0) {
@@ -652,15 +700,26 @@ static av_cold void uninit(AVFilterContext *ctx)
     for (i = 0; i < 4; i++) {
         PlaneContext *p = &s->planes[i];
 
-        av_freep(&p->hdata);
-        av_freep(&p->vdata);
         av_freep(&p->buffer[PREV]);
         av_freep(&p->buffer[CURRENT]);
         av_freep(&p->buffer[NEXT]);
-        av_fft_end(p->fft);
-        av_fft_end(p->ifft);
     }
 
+    for (i = 0; i < s->nb_threads; i++) {
+        if (s->hdata)
+            av_freep(&s->hdata[i]);
+        if (s->vdata)
+            av_freep(&s->vdata[i]);
+        if (s->fft)
+            av_tx_uninit(&s->fft[i]);
+        if (s->ifft)
+            av_tx_uninit(&s->ifft[i]);
+    }
+    av_freep(&s->hdata);
+    av_freep(&s->vdata);
+    av_freep(&s->fft);
+    av_freep(&s->ifft);
+
     av_frame_free(&s->prev);
     av_frame_free(&s->cur);
     av_frame_free(&s->next);
@@ -689,11 +748,10 @@ AVFilter ff_vf_fftdnoiz = {
     .name          = "fftdnoiz",
     .description   = NULL_IF_CONFIG_SMALL("Denoise frames using 3D FFT."),
     .priv_size     = sizeof(FFTdnoizContext),
-    .init          = init,
     .uninit        = uninit,
     .query_formats = query_formats,
     .inputs        = fftdnoiz_inputs,
     .outputs       = fftdnoiz_outputs,
     .priv_class    = &fftdnoiz_class,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL | AVFILTER_FLAG_SLICE_THREADS,
 };
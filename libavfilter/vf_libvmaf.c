@@ -36,6 +36,10 @@
 #include "internal.h"
 #include "video.h"
 
+/* Number of frame pairs that may be queued for the libvmaf thread before
+ * the filter blocks, so that the graph and libvmaf can run concurrently. */
+#define MAX_QUEUED_FRAMES 8
+
 typedef struct LIBVMAFContext {
     const AVClass *class;
     FFFrameSync fs;
@@ -48,9 +52,11 @@ typedef struct LIBVMAFContext {
     pthread_mutex_t lock;
     pthread_cond_t cond;
     int eof;
-    AVFrame *gmain;
-    AVFrame *gref;
-    int frame_set;
+    AVFrame *gmain[MAX_QUEUED_FRAMES];
+    AVFrame *gref[MAX_QUEUED_FRAMES];
+    int queue_start;
+    int nb_queued;
+    uint64_t nb_frames;
     char *model_path;
     char *log_path;
     char *log_fmt;
@@ -94,60 +100,66 @@ FRAMESYNC_DEFINE_CLASS(libvmaf, LIBVMAFContext, fs);
                                       float *temp_data, int stride, void *ctx)  \
 {                                                                               \
     LIBVMAFContext *s = (LIBVMAFContext *) ctx;                                 \
-    int ret;                                                                    \
+    AVFrame *gref, *gmain;                                                      \
     \
     pthread_mutex_lock(&s->lock);                                               \
     \
-    while (!s->frame_set && !s->eof) {                                          \
+    while (!s->nb_queued && !s->eof) {                                          \
         pthread_cond_wait(&s->cond, &s->lock);                                  \
     }                                                                           \
     \
-    if (s->frame_set) {                                                         \
-        int ref_stride = s->gref->linesize[0];                                  \
-        int main_stride = s->gmain->linesize[0];                                \
-        \
-        const type *ref_ptr = (const type *) s->gref->data[0];                  \
-        const type *main_ptr = (const type *) s->gmain->data[0];                \
-        \
-        float *ptr = ref_data;                                                  \
+    if (!s->nb_queued) {                                                        \
+        pthread_mutex_unlock(&s->lock);                                         \
+        return 2;                                                               \
+    }                                                                           \
+    \
+    gref  = s->gref[s->queue_start];                                            \
+    gmain = s->gmain[s->queue_start];                                           \
+    s->gref[s->queue_start]  = NULL;                                            \
+    s->gmain[s->queue_start] = NULL;                                            \
+    s->queue_start = (s->queue_start + 1) % MAX_QUEUED_FRAMES;                  \
+    s->nb_queued--;                                                             \
+    \
+    pthread_cond_signal(&s->cond);                                              \
+    pthread_mutex_unlock(&s->lock);                                             \
+    \
+    {                                                                           \
         float factor = 1.f / (1 << (bits - 8));                                 \
-        \
         int h = s->height;                                                      \
         int w = s->width;                                                       \
+        int i, j;                                                               \
         \
-        int i,j;                                                                \
+        const type *ref_ptr = (const type *) gref->data[0];                     \
+        int ref_stride = gref->linesize[0];                                     \
+        float *ptr = ref_data;                                                  \
         \
         for (i = 0; i < h; i++) {                                               \
-            for ( j = 0; j < w; j++) {                                          \
+            for (j = 0; j < w; j++) {                                           \
                 ptr[j] = ref_ptr[j] * factor;                                   \
             }                                                                   \
             ref_ptr += ref_stride / sizeof(*ref_ptr);                           \
             ptr += stride / sizeof(*ptr);                                       \
         }                                                                       \
         \
-        ptr = main_data;                                                        \
-        \
-        for (i = 0; i < h; i++) {                                               \
-            for (j = 0; j < w; j++) {                                           \
-                ptr[j] = main_ptr[j] * factor;                                  \
+        /* The distorted picture is not looked at for frames skipped by */     \
+        /* n_subsample, so it is neither queued nor converted for them. */     \
+        if (gmain) {                                                            \
+            const type *main_ptr = (const type *) gmain->data[0];               \
+            int main_stride = gmain->linesize[0];                               \
+            \
+            ptr = main_data;                                                    \
+            for (i = 0; i < h; i++) {                                           \
+                for (j = 0; j < w; j++) {                                       \
+                    ptr[j] = main_ptr[j] * factor;                              \
+                }                                                               \
+                main_ptr += main_stride / sizeof(*main_ptr);                    \
+                ptr += stride / sizeof(*ptr);                                   \
             }                                                                   \
-            main_ptr += main_stride / sizeof(*main_ptr);                        \
-            ptr += stride / sizeof(*ptr);                                       \
         }                                                                       \
     }                                                                           \
     \
-    ret = !s->frame_set;                                                        \
-    \
-    av_frame_unref(s->gref);                                                    \
-    av_frame_unref(s->gmain);                                                   \
-    s->frame_set = 0;                                                           \
-    \
-    pthread_cond_signal(&s->cond);                                              \
-    pthread_mutex_unlock(&s->lock);                                             \
-    \
-    if (ret) {                                                                  \
-        return 2;                                                               \
-    }                                                                           \
+    av_frame_free(&gref);                                                       \
+    av_frame_free(&gmain);                                                      \
     \
     return 0;                                                                   \
 }
@@ -196,8 +208,8 @@ static int do_vmaf(FFFrameSync *fs)
 {
     AVFilterContext *ctx = fs->parent;
     LIBVMAFContext *s = ctx->priv;
-    AVFrame *master, *ref;
-    int ret;
+    AVFrame *master, *ref, *gref, *gmain = NULL;
+    int ret, idx;
 
     ret = ff_framesync_dualinput_get(fs, &master, &ref);
     if (ret < 0)
@@ -205,9 +217,18 @@ static int do_vmaf(FFFrameSync *fs)
     if (!ref)
         return ff_filter_frame(ctx->outputs[0], master);
 
+    gref = av_frame_clone(ref);
+    if (!gref)
+        goto fail;
+    if (!(s->nb_frames++ % s->n_subsample)) {
+        gmain = av_frame_clone(master);
+        if (!gmain)
+            goto fail;
+    }
+
     pthread_mutex_lock(&s->lock);
 
-    while (s->frame_set && !s->error) {
+    while (s->nb_queued == MAX_QUEUED_FRAMES && !s->error) {
         pthread_cond_wait(&s->cond, &s->lock);
     }
 
@@ -215,29 +236,31 @@ static int do_vmaf(FFFrameSync *fs)
         av_log(ctx, AV_LOG_ERROR,
                "libvmaf encountered an error, check log for details\n");
         pthread_mutex_unlock(&s->lock);
+        av_frame_free(&gref);
+        av_frame_free(&gmain);
+        av_frame_free(&master);
         return AVERROR(EINVAL);
     }
 
-    av_frame_ref(s->gref, ref);
-    av_frame_ref(s->gmain, master);
-
-    s->frame_set = 1;
+    idx = (s->queue_start + s->nb_queued) % MAX_QUEUED_FRAMES;
+    s->gref[idx]  = gref;
+    s->gmain[idx] = gmain;
+    s->nb_queued++;
 
     pthread_cond_signal(&s->cond);
     pthread_mutex_unlock(&s->lock);
 
     return ff_filter_frame(ctx->outputs[0], master);
+fail:
+    av_frame_free(&gref);
+    av_frame_free(&master);
+    return AVERROR(ENOMEM);
 }
 
 static av_cold int init(AVFilterContext *ctx)
 {
     LIBVMAFContext *s = ctx->priv;
 
-    s->gref = av_frame_alloc();
-    s->gmain = av_frame_alloc();
-    if (!s->gref || !s->gmain)
-        return AVERROR(ENOMEM);
-
     s->error = 0;
 
     s->vmaf_thread_created = 0;
@@ -337,8 +360,10 @@ static av_cold void uninit(AVFilterContext *ctx)
         s->vmaf_thread_created = 0;
     }
 
-    av_frame_free(&s->gref);
-    av_frame_free(&s->gmain);
+    for (int i = 0; i < MAX_QUEUED_FRAMES; i++) {
+        av_frame_free(&s->gref[i]);
+        av_frame_free(&s->gmain[i]);
+    }
 
     pthread_mutex_destroy(&s->lock);
     pthread_cond_destroy(&s->cond);
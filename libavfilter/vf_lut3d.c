@@ -83,6 +83,9 @@ typedef struct LUT3DContext {
     int lutsize;
     int lutsize2;
     Lut3DPreLut prelut;
+    struct rgbvec *shaper;      ///< per-channel LUT coordinate for each integer input code value
+    int shaper_depth;
+    int shaper_ready;
 #if CONFIG_HALDCLUT_FILTER
     uint8_t clut_rgba_map[4];
     int clut_step;
@@ -377,7 +380,7 @@ static int interp_##nbits##_##name##_p##depth(AVFilterContext *ctx, void *arg, i
 {                                                                                                      \
     int x, y;                                                                                          \
     const LUT3DContext *lut3d = ctx->priv;                                                             \
-    const Lut3DPreLut *prelut = &lut3d->prelut;                                                        \
+    const struct rgbvec *shaper = lut3d->shaper;                                                       \
     const ThreadData *td = arg;                                                                        \
     const AVFrame *in  = td->in;                                                                       \
     const AVFrame *out = td->out;                                                                      \
@@ -392,11 +395,6 @@ static int interp_##nbits##_##name##_p##depth(AVFilterContext *ctx, void *arg, i
     const uint8_t *srcbrow = in->data[1] + slice_start * in->linesize[1];                              \
     const uint8_t *srcrrow = in->data[2] + slice_start * in->linesize[2];                              \
     const uint8_t *srcarow = in->data[3] + slice_start * in->linesize[3];                              \
-    const float lut_max = lut3d->lutsize - 1;                                                          \
-    const float scale_f = 1.0f / ((1<<depth) - 1);                                                     \
-    const float scale_r = lut3d->scale.r * lut_max;                                                    \
-    const float scale_g = lut3d->scale.g * lut_max;                                                    \
-    const float scale_b = lut3d->scale.b * lut_max;                                                    \
                                                                                                        \
     for (y = slice_start; y < slice_end; y++) {                                                        \
         uint##nbits##_t *dstg = (uint##nbits##_t *)grow;                                               \
@@ -408,13 +406,9 @@ static int interp_##nbits##_##name##_p##depth(AVFilterContext *ctx, void *arg, i
         const uint##nbits##_t *srcr = (const uint##nbits##_t *)srcrrow;                                \
         const uint##nbits##_t *srca = (const uint##nbits##_t *)srcarow;                                \
         for (x = 0; x < in->width; x++) {                                                              \
-            const struct rgbvec rgb = {srcr[x] * scale_f,                                              \
-                                       srcg[x] * scale_f,                                              \
-                                       srcb[x] * scale_f};                                             \
-            const struct rgbvec prelut_rgb = apply_prelut(prelut, &rgb);                               \
-            const struct rgbvec scaled_rgb = {av_clipf(prelut_rgb.r * scale_r, 0, lut_max),            \
-                                              av_clipf(prelut_rgb.g * scale_g, 0, lut_max),            \
-                                              av_clipf(prelut_rgb.b * scale_b, 0, lut_max)};           \
+            const struct rgbvec scaled_rgb = {shaper[srcr[x]].r,                                       \
+                                              shaper[srcg[x]].g,                                       \
+                                              shaper[srcb[x]].b};                                      \
             struct rgbvec vec = interp_##name(lut3d, &scaled_rgb);                                     \
             dstr[x] = av_clip_uintp2(vec.r * (float)((1<<depth) - 1), depth);                          \
             dstg[x] = av_clip_uintp2(vec.g * (float)((1<<depth) - 1), depth);                          \
@@ -542,7 +536,7 @@ static int interp_##nbits##_##name(AVFilterContext *ctx, void *arg, int jobnr, i
 {                                                                                                   \
     int x, y;                                                                                       \
     const LUT3DContext *lut3d = ctx->priv;                                                          \
-    const Lut3DPreLut *prelut = &lut3d->prelut;                                                     \
+    const struct rgbvec *shaper = lut3d->shaper;                                                    \
     const ThreadData *td = arg;                                                                     \
     const AVFrame *in  = td->in;                                                                    \
     const AVFrame *out = td->out;                                                                   \
@@ -556,23 +550,14 @@ static int interp_##nbits##_##name(AVFilterContext *ctx, void *arg, int jobnr, i
     const int slice_end   = (in->height * (jobnr+1)) / nb_jobs;                                     \
     uint8_t       *dstrow = out->data[0] + slice_start * out->linesize[0];                          \
     const uint8_t *srcrow = in ->data[0] + slice_start * in ->linesize[0];                          \
-    const float lut_max = lut3d->lutsize - 1;                                                       \
-    const float scale_f = 1.0f / ((1<<nbits) - 1);                                                  \
-    const float scale_r = lut3d->scale.r * lut_max;                                                 \
-    const float scale_g = lut3d->scale.g * lut_max;                                                 \
-    const float scale_b = lut3d->scale.b * lut_max;                                                 \
                                                                                                     \
     for (y = slice_start; y < slice_end; y++) {                                                     \
         uint##nbits##_t *dst = (uint##nbits##_t *)dstrow;                                           \
         const uint##nbits##_t *src = (const uint##nbits##_t *)srcrow;                               \
         for (x = 0; x < in->width * step; x += step) {                                              \
-            const struct rgbvec rgb = {src[x + r] * scale_f,                                        \
-                                       src[x + g] * scale_f,                                        \
-                                       src[x + b] * scale_f};                                       \
-            const struct rgbvec prelut_rgb = apply_prelut(prelut, &rgb);                            \
-            const struct rgbvec scaled_rgb = {av_clipf(prelut_rgb.r * scale_r, 0, lut_max),         \
-                                              av_clipf(prelut_rgb.g * scale_g, 0, lut_max),         \
-                                              av_clipf(prelut_rgb.b * scale_b, 0, lut_max)};        \
+            const struct rgbvec scaled_rgb = {shaper[src[x + r]].r,                                 \
+                                              shaper[src[x + g]].g,                                 \
+                                              shaper[src[x + b]].b};                                \
             struct rgbvec vec = interp_##name(lut3d, &scaled_rgb);                                  \
             dst[x + r] = av_clip_uint##nbits(vec.r * (float)((1<<nbits) - 1));                      \
             dst[x + g] = av_clip_uint##nbits(vec.g * (float)((1<<nbits) - 1));                      \
@@ -686,6 +671,7 @@ static int allocate_3dlut(AVFilterContext *ctx, int lutsize, int prelut)
     }
     lut3d->lutsize = lutsize;
     lut3d->lutsize2 = lutsize * lutsize;
+    lut3d->shaper_ready = 0;
     return 0;
 }
 
@@ -1185,6 +1171,16 @@ static int config_input(AVFilterLink *inlink)
     ff_fill_rgba_map(lut3d->rgba_map, inlink->format);
     lut3d->step = av_get_padded_bits_per_pixel(desc) >> (3 + is16bit);
 
+    av_freep(&lut3d->shaper);
+    lut3d->shaper_ready = 0;
+    if (!isfloat) {
+        /* cover the whole storage range so that stray high bits stay in bounds */
+        lut3d->shaper = av_malloc_array(1 << (is16bit ? 16 : 8), sizeof(*lut3d->shaper));
+        if (!lut3d->shaper)
+            return AVERROR(ENOMEM);
+        lut3d->shaper_depth = depth;
+    }
+
 #define SET_FUNC(name) do {                                     \
     if (planar && !isfloat) {                                   \
         switch (depth) {                                        \
@@ -1213,6 +1209,33 @@ static int config_input(AVFilterLink *inlink)
     return 0;
 }
 
+/**
+ * Fill the shaper table: for integer input the scale, pre-LUT and clipping
+ * steps only depend on the code value of each channel, so compute them once
+ * per input value instead of once per pixel.
+ */
+static void build_shaper(LUT3DContext *lut3d)
+{
+    const Lut3DPreLut *prelut = &lut3d->prelut;
+    const int nb_values = 1 << (lut3d->shaper_depth > 8 ? 16 : 8);
+    const float lut_max = lut3d->lutsize - 1;
+    const float scale_f = 1.0f / ((1 << lut3d->shaper_depth) - 1);
+    const float scale_r = lut3d->scale.r * lut_max;
+    const float scale_g = lut3d->scale.g * lut_max;
+    const float scale_b = lut3d->scale.b * lut_max;
+    int i;
+
+    for (i = 0; i < nb_values; i++) {
+        const struct rgbvec rgb = {i * scale_f, i * scale_f, i * scale_f};
+        const struct rgbvec prelut_rgb = apply_prelut(prelut, &rgb);
+
+        lut3d->shaper[i].r = av_clipf(prelut_rgb.r * scale_r, 0, lut_max);
+        lut3d->shaper[i].g = av_clipf(prelut_rgb.g * scale_g, 0, lut_max);
+        lut3d->shaper[i].b = av_clipf(prelut_rgb.b * scale_b, 0, lut_max);
+    }
+    lut3d->shaper_ready = 1;
+}
+
 static AVFrame *apply_lut(AVFilterLink *inlink, AVFrame *in)
 {
     AVFilterContext *ctx = inlink->dst;
@@ -1232,6 +1255,9 @@ static AVFrame *apply_lut(AVFilterLink *inlink, AVFrame *in)
         av_frame_copy_props(out, in);
     }
 
+    if (lut3d->shaper && !lut3d->shaper_ready)
+        build_shaper(lut3d);
+
     td.in  = in;
     td.out = out;
     ctx->internal->execute(ctx, lut3d->interp, &td, NULL, FFMIN(outlink->h, ff_filter_get_nb_threads(ctx)));
@@ -1329,6 +1355,7 @@ static av_cold void lut3d_uninit(AVFilterContext *ctx)
     LUT3DContext *lut3d = ctx->priv;
     int i;
     av_freep(&lut3d->lut);
+    av_freep(&lut3d->shaper);
 
     for (i = 0; i < 3; i++) {
         av_freep(&lut3d->prelut.lut[i]);
@@ -1590,6 +1617,7 @@ static av_cold void haldclut_uninit(AVFilterContext *ctx)
     LUT3DContext *lut3d = ctx->priv;
     ff_framesync_uninit(&lut3d->fs);
     av_freep(&lut3d->lut);
+    av_freep(&lut3d->shaper);
 }
 
 static const AVOption haldclut_options[] = {
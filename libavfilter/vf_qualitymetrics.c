@@ -0,0 +1,613 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Calculate PSNR, SSIM and VMAF motion between two input videos in a
+ * single pass.
+ *
+ * Every slice job walks its rows once, 4 lines at a time, and feeds the
+ * same lines to the PSNR, SSIM and motion kernels while they are still
+ * in cache. The results are exported with the same metadata keys as the
+ * psnr, ssim and vmafmotion filters.
+ */
+
+#include "libavutil/avstring.h"
+#include "libavutil/opt.h"
+#include "libavutil/pixdesc.h"
+#include "avfilter.h"
+#include "drawutils.h"
+#include "formats.h"
+#include "framesync.h"
+#include "internal.h"
+#include "psnr.h"
+#include "ssim.h"
+#include "vmaf_motion.h"
+#include "video.h"
+
+/* must match the fixed point precision used by vf_vmafmotion.c */
+#define MOTION_BIT_SHIFT 15
+
+#define SUM_LEN(w) (((w) >> 2) + 3)
+
+typedef struct ThreadScore {
+    uint64_t sse[4];
+    double ssim[4];
+    uint64_t sad;
+} ThreadScore;
+
+typedef struct QualityMetricsContext {
+    const AVClass *class;
+    FFFrameSync fs;
+    FILE *stats_file;
+    char *stats_file_str;
+    int do_psnr;
+    int do_ssim;
+    int do_motion;
+
+    int nb_components;
+    int nb_threads;
+    int depth;
+    int is_rgb;
+    uint8_t rgba_map[4];
+    char comps[4];
+    int planewidth[4];
+    int planeheight[4];
+    double planeweight[4];
+    int max[4], average_max;
+    uint64_t nb_frames;
+
+    double mse, min_mse, max_mse, mse_comp[4];
+    double ssim[4], ssim_total;
+
+    ThreadScore *score;
+    void **temp;
+
+    PSNRDSPContext psnr_dsp;
+    SSIMDSPContext ssim_dsp;
+    VMAFMotionData motion;
+    void (*blur_row)(const uint16_t *filter, const uint8_t *src,
+                     ptrdiff_t src_stride, uint16_t *dst,
+                     int w, int h, int y);
+} QualityMetricsContext;
+
+#define OFFSET(x) offsetof(QualityMetricsContext, x)
+#define FLAGS AV_OPT_FLAG_FILTERING_PARAM|AV_OPT_FLAG_VIDEO_PARAM
+
+static const AVOption qualitymetrics_options[] = {
+    { "psnr",       "Calculate PSNR",                      OFFSET(do_psnr),        AV_OPT_TYPE_BOOL,   {.i64=1},    0, 1, FLAGS },
+    { "ssim",       "Calculate SSIM",                      OFFSET(do_ssim),        AV_OPT_TYPE_BOOL,   {.i64=1},    0, 1, FLAGS },
+    { "vmafmotion", "Calculate VMAF motion of the reference", OFFSET(do_motion),   AV_OPT_TYPE_BOOL,   {.i64=1},    0, 1, FLAGS },
+    { "stats_file", "Set file where to store per-frame information", OFFSET(stats_file_str), AV_OPT_TYPE_STRING, {.str=NULL}, 0, 0, FLAGS },
+    { "f",          "Set file where to store per-frame information", OFFSET(stats_file_str), AV_OPT_TYPE_STRING, {.str=NULL}, 0, 0, FLAGS },
+    { NULL }
+};
+
+FRAMESYNC_DEFINE_CLASS(qualitymetrics, QualityMetricsContext, fs);
+
+static inline unsigned pow_2(unsigned base)
+{
+    return base*base;
+}
+
+static inline double get_psnr(double mse, uint64_t nb_frames, int max)
+{
+    return 10.0 * log10(pow_2(max) / (mse / nb_frames));
+}
+
+static double ssim_db(double ssim, double weight)
+{
+    return (fabs(weight - ssim) > 1e-9) ? 10.0 * log10(weight / (weight - ssim)) : INFINITY;
+}
+
+/* Vertical part of the VMAF motion blur for a single output line, with the
+ * same mirrored borders as the full frame convolution in vf_vmafmotion.c. */
+#define BLUR_ROW(type, bits)                                                   \
+static void blur_row_##bits##bit(const uint16_t *filter, const uint8_t *_src,  \
+                                 ptrdiff_t _src_stride, uint16_t *dst,         \
+                                 int w, int h, int y)                          \
+{                                                                              \
+    const type *src = (const type *)_src;                                      \
+    ptrdiff_t src_stride = _src_stride / sizeof(*src);                         \
+    const type *taps[5];                                                       \
+                                                                               \
+    for (int k = 0; k < 5; k++) {                                              \
+        int i_tap = FFABS(y - 2 + k);                                          \
+        if (i_tap >= h)                                                        \
+            i_tap = h - (i_tap - h + 1);                                       \
+        taps[k] = src + i_tap * src_stride;                                    \
+    }                                                                          \
+                                                                               \
+    for (int j = 0; j < w; j++) {                                              \
+        int sum = 0;                                                           \
+        for (int k = 0; k < 5; k++)                                            \
+            sum += filter[k] * taps[k][j];                                     \
+        dst[j] = sum >> bits;                                                  \
+    }                                                                          \
+}
+
+BLUR_ROW(uint8_t, 8)
+BLUR_ROW(uint16_t, 10)
+
+typedef struct ThreadData {
+    const uint8_t *main_data[4];
+    const uint8_t *ref_data[4];
+    int main_linesize[4];
+    int ref_linesize[4];
+    int do_sad;
+} ThreadData;
+
+static void process_lines(QualityMetricsContext *s, ThreadData *td,
+                          ThreadScore *score, int c, int start, int end)
+{
+    const int w = s->planewidth[c];
+
+    if (s->do_psnr) {
+        const uint8_t *main_line = td->main_data[c] + td->main_linesize[c] * start;
+        const uint8_t *ref_line  = td->ref_data[c]  + td->ref_linesize[c]  * start;
+        uint64_t m = 0;
+
+        for (int y = start; y < end; y++) {
+            m += s->psnr_dsp.sse_line(main_line, ref_line, w);
+            main_line += td->main_linesize[c];
+            ref_line  += td->ref_linesize[c];
+        }
+        score->sse[c] += m;
+    }
+
+    if (s->do_motion && c == 0) {
+        VMAFMotionData *m = &s->motion;
+        const ptrdiff_t stride = m->stride / sizeof(uint16_t);
+
+        for (int y = start; y < end; y++) {
+            uint16_t *temp = m->temp_data    + y * stride;
+            uint16_t *cur  = m->blur_data[0] + y * stride;
+            uint16_t *prev = m->blur_data[1] + y * stride;
+
+            s->blur_row(m->filter, td->ref_data[0], td->ref_linesize[0],
+                        temp, w, m->height, y);
+            m->vmafdsp.convolution_x(m->filter, 5, temp, cur, w, 1,
+                                     m->stride, m->stride);
+            if (td->do_sad)
+                score->sad += m->vmafdsp.sad(prev, cur, w, 1,
+                                             m->stride, m->stride);
+        }
+    }
+}
+
+static void ssim_blocks(QualityMetricsContext *s, ThreadData *td, int c,
+                        void *sums, int z)
+{
+    const int main_stride = td->main_linesize[c];
+    const int ref_stride  = td->ref_linesize[c];
+    const uint8_t *main_data = td->main_data[c] + 4 * z * main_stride;
+    const uint8_t *ref_data  = td->ref_data[c]  + 4 * z * ref_stride;
+    const int width = s->planewidth[c] >> 2;
+
+    if (s->depth > 8)
+        ff_ssim_4x4xn_16bit(main_data, main_stride, ref_data, ref_stride,
+                            sums, width);
+    else
+        s->ssim_dsp.ssim_4x4_line(main_data, main_stride, ref_data, ref_stride,
+                                  sums, width);
+}
+
+static double ssim_end(QualityMetricsContext *s, int c,
+                       const void *sum0, const void *sum1)
+{
+    const int width = (s->planewidth[c] >> 2) - 1;
+
+    if (s->depth > 8)
+        return ff_ssim_endn_16bit(sum0, sum1, width, s->max[0]);
+    return s->ssim_dsp.ssim_end_line(sum0, sum1, width);
+}
+
+static int compute_metrics(AVFilterContext *ctx, void *arg,
+                           int jobnr, int nb_jobs)
+{
+    QualityMetricsContext *s = ctx->priv;
+    ThreadData *td = arg;
+    ThreadScore *score = &s->score[jobnr];
+    const size_t sum_size = s->depth > 8 ? sizeof(int64_t[4]) : sizeof(int[4]);
+
+    memset(score, 0, sizeof(*score));
+
+    for (int c = 0; c < s->nb_components; c++) {
+        const int height = s->planeheight[c];
+        const int block_rows = height >> 2;
+        const int slice_start = (block_rows * jobnr) / nb_jobs;
+        const int slice_end = (block_rows * (jobnr+1)) / nb_jobs;
+        uint8_t *sum0 = s->temp[jobnr];
+        uint8_t *sum1 = sum0 + SUM_LEN(s->planewidth[c]) * sum_size;
+        double ssim = 0.0;
+
+        if (s->do_ssim && slice_start > 0 && slice_start < slice_end)
+            ssim_blocks(s, td, c, sum0, slice_start - 1);
+
+        for (int y = slice_start; y < slice_end; y++) {
+            process_lines(s, td, score, c, 4 * y, 4 * y + 4);
+
+            if (s->do_ssim) {
+                FFSWAP(uint8_t *, sum0, sum1);
+                ssim_blocks(s, td, c, sum0, y);
+                if (y > 0)
+                    ssim += ssim_end(s, c, sum0, sum1);
+            }
+        }
+
+        if (jobnr == nb_jobs - 1)
+            process_lines(s, td, score, c, 4 * block_rows, height);
+
+        score->ssim[c] = ssim;
+    }
+
+    return 0;
+}
+
+static void set_meta(AVDictionary **metadata, const char *key, char comp, float d)
+{
+    char value[128];
+    snprintf(value, sizeof(value), "%f", d);
+    if (comp) {
+        char key2[128];
+        snprintf(key2, sizeof(key2), "%s%c", key, comp);
+        av_dict_set(metadata, key2, value, 0);
+    } else {
+        av_dict_set(metadata, key, value, 0);
+    }
+}
+
+static int do_metrics(FFFrameSync *fs)
+{
+    AVFilterContext *ctx = fs->parent;
+    QualityMetricsContext *s = ctx->priv;
+    AVFrame *master, *ref;
+    AVDictionary **metadata;
+    uint64_t comp_sse[4] = { 0 }, sad = 0;
+    double comp_mse[4], comp_ssim[4] = { 0 };
+    double mse = 0., ssimv = 0., motion = 0.;
+    ThreadData td;
+    int nb_jobs, ret;
+
+    ret = ff_framesync_dualinput_get(fs, &master, &ref);
+    if (ret < 0)
+        return ret;
+    if (ctx->is_disabled || !ref)
+        return ff_filter_frame(ctx->outputs[0], master);
+    metadata = &master->metadata;
+
+    for (int c = 0; c < s->nb_components; c++) {
+        td.main_data[c] = master->data[c];
+        td.ref_data[c] = ref->data[c];
+        td.main_linesize[c] = master->linesize[c];
+        td.ref_linesize[c] = ref->linesize[c];
+    }
+    td.do_sad = s->do_motion && s->motion.nb_frames > 0;
+
+    nb_jobs = FFMIN((s->planeheight[1] + 3) >> 2, s->nb_threads);
+    ctx->internal->execute(ctx, compute_metrics, &td, NULL, nb_jobs);
+
+    for (int j = 0; j < nb_jobs; j++) {
+        for (int c = 0; c < s->nb_components; c++) {
+            comp_sse[c]  += s->score[j].sse[c];
+            comp_ssim[c] += s->score[j].ssim[c];
+        }
+        sad += s->score[j].sad;
+    }
+
+    s->nb_frames++;
+
+    if (s->do_psnr) {
+        for (int c = 0; c < s->nb_components; c++) {
+            comp_mse[c] = comp_sse[c] / ((double)s->planewidth[c] * s->planeheight[c]);
+            mse += comp_mse[c] * s->planeweight[c];
+            s->mse_comp[c] += comp_mse[c];
+        }
+        s->min_mse = FFMIN(s->min_mse, mse);
+        s->max_mse = FFMAX(s->max_mse, mse);
+        s->mse += mse;
+
+        for (int j = 0; j < s->nb_components; j++) {
+            int c = s->is_rgb ? s->rgba_map[j] : j;
+            set_meta(metadata, "lavfi.psnr.mse.", s->comps[j], comp_mse[c]);
+            set_meta(metadata, "lavfi.psnr.psnr.", s->comps[j], get_psnr(comp_mse[c], 1, s->max[c]));
+        }
+        set_meta(metadata, "lavfi.psnr.mse_avg", 0, mse);
+        set_meta(metadata, "lavfi.psnr.psnr_avg", 0, get_psnr(mse, 1, s->average_max));
+    }
+
+    if (s->do_ssim) {
+        for (int c = 0; c < s->nb_components; c++) {
+            comp_ssim[c] /= ((s->planewidth[c] >> 2) - 1) * ((s->planeheight[c] >> 2) - 1);
+            ssimv += s->planeweight[c] * comp_ssim[c];
+            s->ssim[c] += comp_ssim[c];
+        }
+        s->ssim_total += ssimv;
+
+        for (int j = 0; j < s->nb_components; j++) {
+            int c = s->is_rgb ? s->rgba_map[j] : j;
+            set_meta(metadata, "lavfi.ssim.", av_toupper(s->comps[j]), comp_ssim[c]);
+        }
+        set_meta(metadata, "lavfi.ssim.All", 0, ssimv);
+        set_meta(metadata, "lavfi.ssim.dB", 0, ssim_db(ssimv, 1.0));
+    }
+
+    if (s->do_motion) {
+        VMAFMotionData *m = &s->motion;
+        char value[128];
+
+        // the output score is always normalized to 8 bits
+        if (td.do_sad)
+            motion = sad * 1.0 / (m->width * m->height << (MOTION_BIT_SHIFT - 8));
+        FFSWAP(uint16_t *, m->blur_data[0], m->blur_data[1]);
+        m->nb_frames++;
+        m->motion_sum += motion;
+
+        snprintf(value, sizeof(value), "%0.2f", motion);
+        av_dict_set(metadata, "lavfi.vmafmotion.score", value, 0);
+    }
+
+    if (s->stats_file) {
+        fprintf(s->stats_file, "n:%"PRId64, s->nb_frames);
+        if (s->do_psnr)
+            fprintf(s->stats_file, " mse_avg:%0.2f psnr_avg:%0.2f",
+                    mse, get_psnr(mse, 1, s->average_max));
+        if (s->do_ssim)
+            fprintf(s->stats_file, " ssim_All:%f (%f)", ssimv, ssim_db(ssimv, 1.0));
+        if (s->do_motion)
+            fprintf(s->stats_file, " motion:%0.2f", motion);
+        fprintf(s->stats_file, "\n");
+    }
+
+    return ff_filter_frame(ctx->outputs[0], master);
+}
+
+static av_cold int init(AVFilterContext *ctx)
+{
+    QualityMetricsContext *s = ctx->priv;
+
+    s->min_mse = +INFINITY;
+    s->max_mse = -INFINITY;
+
+    if (s->stats_file_str) {
+        if (!strcmp(s->stats_file_str, "-")) {
+            s->stats_file = stdout;
+        } else {
+            s->stats_file = fopen(s->stats_file_str, "w");
+            if (!s->stats_file) {
+                int err = AVERROR(errno);
+                char buf[128];
+                av_strerror(err, buf, sizeof(buf));
+                av_log(ctx, AV_LOG_ERROR, "Could not open stats file %s: %s\n",
+                       s->stats_file_str, buf);
+                return err;
+            }
+        }
+    }
+
+    s->fs.on_event = do_metrics;
+    return 0;
+}
+
+static int query_formats(AVFilterContext *ctx)
+{
+    static const enum AVPixelFormat pix_fmts[] = {
+        AV_PIX_FMT_GRAY8, AV_PIX_FMT_GRAY9, AV_PIX_FMT_GRAY10,
+        AV_PIX_FMT_GRAY12, AV_PIX_FMT_GRAY14, AV_PIX_FMT_GRAY16,
+        AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV422P, AV_PIX_FMT_YUV444P,
+        AV_PIX_FMT_YUV440P, AV_PIX_FMT_YUV411P, AV_PIX_FMT_YUV410P,
+        AV_PIX_FMT_YUVJ411P, AV_PIX_FMT_YUVJ420P, AV_PIX_FMT_YUVJ422P,
+        AV_PIX_FMT_YUVJ440P, AV_PIX_FMT_YUVJ444P,
+        AV_PIX_FMT_GBRP,
+#define PF(suf) AV_PIX_FMT_YUV420##suf,  AV_PIX_FMT_YUV422##suf,  AV_PIX_FMT_YUV444##suf, AV_PIX_FMT_GBR##suf
+        PF(P9), PF(P10), PF(P12), PF(P14), PF(P16),
+        AV_PIX_FMT_NONE
+    };
+
+    AVFilterFormats *fmts_list = ff_make_format_list(pix_fmts);
+    if (!fmts_list)
+        return AVERROR(ENOMEM);
+    return ff_set_common_formats(ctx, fmts_list);
+}
+
+static int config_input_ref(AVFilterLink *inlink)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(inlink->format);
+    AVFilterContext *ctx  = inlink->dst;
+    QualityMetricsContext *s = ctx->priv;
+    double average_max = 0;
+    int sum = 0, ret;
+
+    s->nb_threads = ff_filter_get_nb_threads(ctx);
+    s->nb_components = desc->nb_components;
+    s->depth = desc->comp[0].depth;
+
+    if (ctx->inputs[0]->w != ctx->inputs[1]->w ||
+        ctx->inputs[0]->h != ctx->inputs[1]->h) {
+        av_log(ctx, AV_LOG_ERROR, "Width and height of input videos must be same.\n");
+        return AVERROR(EINVAL);
+    }
+    if (ctx->inputs[0]->format != ctx->inputs[1]->format) {
+        av_log(ctx, AV_LOG_ERROR, "Inputs must be of same pixel format.\n");
+        return AVERROR(EINVAL);
+    }
+
+    s->is_rgb = ff_fill_rgba_map(s->rgba_map, inlink->format) >= 0;
+    s->comps[0] = s->is_rgb ? 'r' : 'y';
+    s->comps[1] = s->is_rgb ? 'g' : 'u';
+    s->comps[2] = s->is_rgb ? 'b' : 'v';
+    s->comps[3] = 'a';
+
+    s->planeheight[1] = s->planeheight[2] = AV_CEIL_RSHIFT(inlink->h, desc->log2_chroma_h);
+    s->planeheight[0] = s->planeheight[3] = inlink->h;
+    s->planewidth[1]  = s->planewidth[2]  = AV_CEIL_RSHIFT(inlink->w, desc->log2_chroma_w);
+    s->planewidth[0]  = s->planewidth[3]  = inlink->w;
+    for (int c = 0; c < s->nb_components; c++)
+        sum += s->planeheight[c] * s->planewidth[c];
+    for (int c = 0; c < s->nb_components; c++) {
+        s->max[c] = (1 << desc->comp[c].depth) - 1;
+        s->planeweight[c] = (double) s->planeheight[c] * s->planewidth[c] / sum;
+        average_max += s->max[c] * s->planeweight[c];
+    }
+    s->average_max = lrint(average_max);
+
+    ff_psnr_init(&s->psnr_dsp, s->depth);
+    ff_ssim_init(&s->ssim_dsp);
+
+    if (s->do_motion && s->depth != 8 && s->depth != 10) {
+        av_log(ctx, AV_LOG_WARNING, "VMAF motion is only supported for 8 and "
+               "10 bit input, disabling it.\n");
+        s->do_motion = 0;
+    }
+    if (s->do_motion) {
+        ret = ff_vmafmotion_init(&s->motion, inlink->w, inlink->h, inlink->format);
+        if (ret < 0)
+            return ret;
+        s->blur_row = s->depth == 10 ? blur_row_10bit : blur_row_8bit;
+    }
+
+    s->score = av_calloc(s->nb_threads, sizeof(*s->score));
+    s->temp  = av_calloc(s->nb_threads, sizeof(*s->temp));
+    if (!s->score || !s->temp)
+        return AVERROR(ENOMEM);
+
+    for (int t = 0; t < s->nb_threads; t++) {
+        s->temp[t] = av_mallocz_array(2 * SUM_LEN(inlink->w), s->depth > 8 ? sizeof(int64_t[4]) : sizeof(int[4]));
+        if (!s->temp[t])
+            return AVERROR(ENOMEM);
+    }
+
+    return 0;
+}
+
+static int config_output(AVFilterLink *outlink)
+{
+    AVFilterContext *ctx = outlink->src;
+    QualityMetricsContext *s = ctx->priv;
+    AVFilterLink *mainlink = ctx->inputs[0];
+    int ret;
+
+    ret = ff_framesync_init_dualinput(&s->fs, ctx);
+    if (ret < 0)
+        return ret;
+    outlink->w = mainlink->w;
+    outlink->h = mainlink->h;
+    outlink->time_base = mainlink->time_base;
+    outlink->sample_aspect_ratio = mainlink->sample_aspect_ratio;
+    outlink->frame_rate = mainlink->frame_rate;
+    if ((ret = ff_framesync_configure(&s->fs)) < 0)
+        return ret;
+
+    outlink->time_base = s->fs.time_base;
+
+    if (av_cmp_q(mainlink->time_base, outlink->time_base) ||
+        av_cmp_q(ctx->inputs[1]->time_base, outlink->time_base))
+        av_log(ctx, AV_LOG_WARNING, "not matching timebases found between first input: %d/%d and second input %d/%d, results may be incorrect!\n",
+               mainlink->time_base.num, mainlink->time_base.den,
+               ctx->inputs[1]->time_base.num, ctx->inputs[1]->time_base.den);
+
+    return 0;
+}
+
+static int activate(AVFilterContext *ctx)
+{
+    QualityMetricsContext *s = ctx->priv;
+    return ff_framesync_activate(&s->fs);
+}
+
+static av_cold void uninit(AVFilterContext *ctx)
+{
+    QualityMetricsContext *s = ctx->priv;
+    double avg_motion = ff_vmafmotion_uninit(&s->motion);
+
+    if (s->nb_frames > 0) {
+        char buf[256];
+
+        if (s->do_psnr) {
+            buf[0] = 0;
+            for (int j = 0; j < s->nb_components; j++) {
+                int c = s->is_rgb ? s->rgba_map[j] : j;
+                av_strlcatf(buf, sizeof(buf), " %c:%f", s->comps[j],
+                            get_psnr(s->mse_comp[c], s->nb_frames, s->max[c]));
+            }
+            av_log(ctx, AV_LOG_INFO, "PSNR%s average:%f min:%f max:%f\n",
+                   buf,
+                   get_psnr(s->mse, s->nb_frames, s->average_max),
+                   get_psnr(s->max_mse, 1, s->average_max),
+                   get_psnr(s->min_mse, 1, s->average_max));
+        }
+        if (s->do_ssim) {
+            buf[0] = 0;
+            for (int j = 0; j < s->nb_components; j++) {
+                int c = s->is_rgb ? s->rgba_map[j] : j;
+                av_strlcatf(buf, sizeof(buf), " %c:%f (%f)", av_toupper(s->comps[j]),
+                            s->ssim[c] / s->nb_frames, ssim_db(s->ssim[c], s->nb_frames));
+            }
+            av_log(ctx, AV_LOG_INFO, "SSIM%s All:%f (%f)\n", buf,
+                   s->ssim_total / s->nb_frames, ssim_db(s->ssim_total, s->nb_frames));
+        }
+        if (s->do_motion)
+            av_log(ctx, AV_LOG_INFO, "VMAF Motion avg: %.3f\n", avg_motion);
+    }
+
+    ff_framesync_uninit(&s->fs);
+
+    for (int t = 0; t < s->nb_threads && s->temp; t++)
+        av_freep(&s->temp[t]);
+    av_freep(&s->temp);
+    av_freep(&s->score);
+
+    if (s->stats_file && s->stats_file != stdout)
+        fclose(s->stats_file);
+}
+
+static const AVFilterPad qualitymetrics_inputs[] = {
+    {
+        .name         = "main",
+        .type         = AVMEDIA_TYPE_VIDEO,
+    },{
+        .name         = "reference",
+        .type         = AVMEDIA_TYPE_VIDEO,
+        .config_props = config_input_ref,
+    },
+    { NULL }
+};
+
+static const AVFilterPad qualitymetrics_outputs[] = {
+    {
+        .name          = "default",
+        .type          = AVMEDIA_TYPE_VIDEO,
+        .config_props  = config_output,
+    },
+    { NULL }
+};
+
+AVFilter ff_vf_qualitymetrics = {
+    .name          = "qualitymetrics",
+    .description   = NULL_IF_CONFIG_SMALL("Calculate PSNR, SSIM and VMAF motion between two video streams in one pass."),
+    .preinit       = qualitymetrics_framesync_preinit,
+    .init          = init,
+    .uninit        = uninit,
+    .query_formats = query_formats,
+    .activate      = activate,
+    .priv_size     = sizeof(QualityMetricsContext),
+    .priv_class    = &qualitymetrics_class,
+    .inputs        = qualitymetrics_inputs,
+    .outputs       = qualitymetrics_outputs,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL | AVFILTER_FLAG_SLICE_THREADS,
+};
@@ -44,6 +44,9 @@ typedef struct SCDetContext {
     AVFrame *prev_picref;
     double threshold;
     int sc_pass;
+
+    int nb_threads;
+    uint64_t *thread_sad;
 } SCDetContext;
 
 #define OFFSET(x) offsetof(SCDetContext, x)
@@ -103,6 +106,11 @@ static int config_input(AVFilterLink *inlink)
     if (!s->sad)
         return AVERROR(EINVAL);
 
+    s->nb_threads = ff_filter_get_nb_threads(ctx);
+    s->thread_sad = av_calloc(s->nb_threads, sizeof(*s->thread_sad));
+    if (!s->thread_sad)
+        return AVERROR(ENOMEM);
+
     return 0;
 }
 
@@ -111,6 +119,36 @@ static av_cold void uninit(AVFilterContext *ctx)
     SCDetContext *s = ctx->priv;
 
     av_frame_free(&s->prev_picref);
+    av_freep(&s->thread_sad);
+}
+
+typedef struct ThreadData {
+    AVFrame *prev, *cur;
+} ThreadData;
+
+static int scene_sad_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    SCDetContext *s = ctx->priv;
+    ThreadData *td = arg;
+    uint64_t sad = 0;
+
+    for (int plane = 0; plane < s->nb_planes; plane++) {
+        const int slice_start = (s->height[plane] * jobnr) / nb_jobs;
+        const int slice_end = (s->height[plane] * (jobnr+1)) / nb_jobs;
+        uint64_t plane_sad;
+
+        if (slice_start == slice_end)
+            continue;
+        s->sad(td->prev->data[plane] + slice_start * td->prev->linesize[plane],
+               td->prev->linesize[plane],
+               td->cur->data[plane] + slice_start * td->cur->linesize[plane],
+               td->cur->linesize[plane],
+               s->width[plane], slice_end - slice_start, &plane_sad);
+        sad += plane_sad;
+    }
+    s->thread_sad[jobnr] = sad;
+
+    return 0;
 }
 
 static double get_scene_score(AVFilterContext *ctx, AVFrame *frame)
@@ -121,18 +159,17 @@ static double get_scene_score(AVFilterContext *ctx, AVFrame *frame)
 
     if (prev_picref && frame->height == prev_picref->height
                     && frame->width  == prev_picref->width) {
+        const int nb_jobs = FFMIN(s->height[0], s->nb_threads);
+        ThreadData td = { .prev = prev_picref, .cur = frame };
         uint64_t sad = 0;
         double mafd, diff;
         uint64_t count = 0;
 
-        for (int plane = 0; plane < s->nb_planes; plane++) {
-            uint64_t plane_sad;
-            s->sad(prev_picref->data[plane], prev_picref->linesize[plane],
-                    frame->data[plane], frame->linesize[plane],
-                    s->width[plane], s->height[plane], &plane_sad);
-            sad += plane_sad;
+        ctx->internal->execute(ctx, scene_sad_slice, &td, NULL, nb_jobs);
+        for (int i = 0; i < nb_jobs; i++)
+            sad += s->thread_sad[i];
+        for (int plane = 0; plane < s->nb_planes; plane++)
             count += s->width[plane] * s->height[plane];
-        }
 
         emms_c();
         mafd = (double)sad * 100. / count / (1ULL << s->bitdepth);
@@ -221,4 +258,5 @@ AVFilter ff_vf_scdet = {
     .inputs        = scdet_inputs,
     .outputs       = scdet_outputs,
     .activate      = activate,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -92,9 +92,9 @@ static void set_meta(AVDictionary **metadata, const char *key, char comp, float
     }
 }
 
-static void ssim_4x4xn_16bit(const uint8_t *main8, ptrdiff_t main_stride,
-                             const uint8_t *ref8, ptrdiff_t ref_stride,
-                             int64_t (*sums)[4], int width)
+void ff_ssim_4x4xn_16bit(const uint8_t *main8, ptrdiff_t main_stride,
+                         const uint8_t *ref8, ptrdiff_t ref_stride,
+                         int64_t (*sums)[4], int width)
 {
     const uint16_t *main16 = (const uint16_t *)main8;
     const uint16_t *ref16  = (const uint16_t *)ref8;
@@ -191,7 +191,7 @@ static float ssim_end1(int s1, int s2, int ss, int s12)
          / ((float)(fs1 * fs1 + fs2 * fs2 + ssim_c1) * (float)(vars + ssim_c2));
 }
 
-static float ssim_endn_16bit(const int64_t (*sum0)[4], const int64_t (*sum1)[4], int width, int max)
+float ff_ssim_endn_16bit(const int64_t (*sum0)[4], const int64_t (*sum1)[4], int width, int max)
 {
     float ssim = 0.0;
     int i;
@@ -218,6 +218,14 @@ static double ssim_endn_8bit(const int (*sum0)[4], const int (*sum1)[4], int wid
     return ssim;
 }
 
+void ff_ssim_init(SSIMDSPContext *dsp)
+{
+    dsp->ssim_4x4_line = ssim_4x4xn_8bit;
+    dsp->ssim_end_line = ssim_endn_8bit;
+    if (ARCH_X86)
+        ff_ssim_init_x86(dsp);
+}
+
 #define SUM_LEN(w) (((w) >> 2) + 3)
 
 typedef struct ThreadData {
@@ -263,12 +271,12 @@ static int ssim_plane_16bit(AVFilterContext *ctx, void *arg,
         for (int y = ystart; y < slice_end; y++) {
             for (; z <= y; z++) {
                 FFSWAP(void*, sum0, sum1);
-                ssim_4x4xn_16bit(&main_data[4 * z * main_stride], main_stride,
-                                 &ref_data[4 * z * ref_stride], ref_stride,
-                                 sum0, width);
+                ff_ssim_4x4xn_16bit(&main_data[4 * z * main_stride], main_stride,
+                                    &ref_data[4 * z * ref_stride], ref_stride,
+                                    sum0, width);
             }
 
-            ssim += ssim_endn_16bit((const int64_t (*)[4])sum0, (const int64_t (*)[4])sum1, width - 1, max);
+            ssim += ff_ssim_endn_16bit((const int64_t (*)[4])sum0, (const int64_t (*)[4])sum1, width - 1, max);
         }
 
         score[c] = ssim;
@@ -487,10 +495,7 @@ static int config_input_ref(AVFilterLink *inlink)
     s->max = (1 << desc->comp[0].depth) - 1;
 
     s->ssim_plane = desc->comp[0].depth > 8 ? ssim_plane_16bit : ssim_plane;
-    s->dsp.ssim_4x4_line = ssim_4x4xn_8bit;
-    s->dsp.ssim_end_line = ssim_endn_8bit;
-    if (ARCH_X86)
-        ff_ssim_init_x86(&s->dsp);
+    ff_ssim_init(&s->dsp);
 
     s->score = av_calloc(s->nb_threads, sizeof(*s->score));
     if (!s->score)
@@ -113,88 +113,96 @@ static float hable(float in)
     return (in * (in * a + b * c) + d * e) / (in * (in * a + b) + d * f) - e / f;
 }
 
-static float mobius(float in, float j, double peak)
-{
-    float a, b;
-
-    if (in <= j)
-        return in;
-
-    a = -j * j * (peak - 1.0f) / (j * j - 2.0f * j + peak);
-    b = (j * j - 2.0f * j * peak + peak) / FFMAX(peak - 1.0f, 1e-6);
-
-    return (b * b + 2.0f * b * j + j * j) / (b - a) * (in + a) / (in + b);
-}
+/* Per-frame constants of the tonemapping curves, so that the per-pixel
+ * loops below only do the minimal amount of arithmetic. The curves keep
+ * the operation order of the per-pixel code they replace. */
+typedef struct TonemapParams {
+    double param;
+    double peak;
+    double exponent;        /* gamma */
+    double low_scale;       /* gamma, for the linear part below 0.05 */
+    float hable_peak;       /* hable */
+    float j, a, b, scale;   /* mobius */
+} TonemapParams;
 
-#define MIX(x,y,a) (x) * (1 - (a)) + (y) * (a)
-static void tonemap(TonemapContext *s, AVFrame *out, const AVFrame *in,
-                    const AVPixFmtDescriptor *desc, int x, int y, double peak)
+static void tonemap_params(TonemapContext *s, TonemapParams *p, double peak)
 {
-    const float *r_in = (const float *)(in->data[0] + x * desc->comp[0].step + y * in->linesize[0]);
-    const float *b_in = (const float *)(in->data[1] + x * desc->comp[1].step + y * in->linesize[1]);
-    const float *g_in = (const float *)(in->data[2] + x * desc->comp[2].step + y * in->linesize[2]);
-    float *r_out = (float *)(out->data[0] + x * desc->comp[0].step + y * out->linesize[0]);
-    float *b_out = (float *)(out->data[1] + x * desc->comp[1].step + y * out->linesize[1]);
-    float *g_out = (float *)(out->data[2] + x * desc->comp[2].step + y * out->linesize[2]);
-    float sig, sig_orig;
-
-    /* load values */
-    *r_out = *r_in;
-    *b_out = *b_in;
-    *g_out = *g_in;
-
-    /* desaturate to prevent unnatural colors */
-    if (s->desat > 0) {
-        float luma = s->coeffs->cr * *r_in + s->coeffs->cg * *g_in + s->coeffs->cb * *b_in;
-        float overbright = FFMAX(luma - s->desat, 1e-6) / FFMAX(luma, 1e-6);
-        *r_out = MIX(*r_in, luma, overbright);
-        *g_out = MIX(*g_in, luma, overbright);
-        *b_out = MIX(*b_in, luma, overbright);
-    }
+    float j = s->param;
 
-    /* pick the brightest component, reducing the value range as necessary
-     * to keep the entire signal in range and preventing discoloration due to
-     * out-of-bounds clipping */
-    sig = FFMAX(FFMAX3(*r_out, *g_out, *b_out), 1e-6);
-    sig_orig = sig;
+    p->param = s->param;
+    p->peak  = peak;
 
-    switch(s->tonemap) {
-    default:
-    case TONEMAP_NONE:
-        // do nothing
-        break;
-    case TONEMAP_LINEAR:
-        sig = sig * s->param / peak;
-        break;
+    switch (s->tonemap) {
     case TONEMAP_GAMMA:
-        sig = sig > 0.05f ? pow(sig / peak, 1.0f / s->param)
-                          : sig * pow(0.05f / peak, 1.0f / s->param) / 0.05f;
-        break;
-    case TONEMAP_CLIP:
-        sig = av_clipf(sig * s->param, 0, 1.0f);
+        p->exponent  = 1.0f / s->param;
+        p->low_scale = pow(0.05f / peak, 1.0f / s->param);
         break;
     case TONEMAP_HABLE:
-        sig = hable(sig) / hable(peak);
-        break;
-    case TONEMAP_REINHARD:
-        sig = sig / (sig + s->param) * (peak + s->param) / peak;
+        p->hable_peak = hable(peak);
         break;
     case TONEMAP_MOBIUS:
-        sig = mobius(sig, s->param, peak);
+        p->j = j;
+        p->a = -j * j * (peak - 1.0f) / (j * j - 2.0f * j + peak);
+        p->b = (j * j - 2.0f * j * peak + peak) / FFMAX(peak - 1.0f, 1e-6);
+        p->scale = (p->b * p->b + 2.0f * p->b * j + j * j) / (p->b - p->a);
         break;
+    default:
+        break;
+    }
+}
+
+#define MIX(x,y,a) (x) * (1 - (a)) + (y) * (a)
+
+/* desaturate to prevent unnatural colors */
+static void desaturate_line(TonemapContext *s, float *c0, float *c1, float *c2,
+                            const float *i0, const float *i1, const float *i2,
+                            int width)
+{
+    const float k0 = s->coeffs->cr, k1 = s->coeffs->cb, k2 = s->coeffs->cg;
+    const float desat = s->desat;
+
+    for (int x = 0; x < width; x++) {
+        float luma = k0 * i0[x] + k2 * i2[x] + k1 * i1[x];
+        float overbright = FFMAX(luma - desat, 1e-6) / FFMAX(luma, 1e-6);
+
+        c0[x] = MIX(i0[x], luma, overbright);
+        c2[x] = MIX(i2[x], luma, overbright);
+        c1[x] = MIX(i1[x], luma, overbright);
     }
+}
 
-    /* apply the computed scale factor to the color,
-     * linearly to prevent discoloration */
-    *r_out *= sig / sig_orig;
-    *g_out *= sig / sig_orig;
-    *b_out *= sig / sig_orig;
+/* pick the brightest component, reducing the value range as necessary
+ * to keep the entire signal in range and preventing discoloration due to
+ * out-of-bounds clipping, then apply the computed scale factor to the
+ * color, linearly to prevent discoloration */
+#define TONEMAP_LINE(name, curve)                                               \
+static void tonemap_line_##name(const TonemapParams *p,                         \
+                                float *c0, float *c1, float *c2, int width)     \
+{                                                                               \
+    for (int x = 0; x < width; x++) {                                           \
+        float sig_orig = FFMAX(FFMAX3(c0[x], c1[x], c2[x]), 1e-6);              \
+        float sig = sig_orig, ratio;                                            \
+                                                                                \
+        curve;                                                                  \
+                                                                                \
+        ratio = sig / sig_orig;                                                 \
+        c0[x] *= ratio;                                                         \
+        c1[x] *= ratio;                                                         \
+        c2[x] *= ratio;                                                         \
+    }                                                                           \
 }
 
+TONEMAP_LINE(linear,   sig = sig * p->param / p->peak)
+TONEMAP_LINE(gamma,    sig = sig > 0.05f ? pow(sig / p->peak, p->exponent)
+                                         : sig * p->low_scale / 0.05f)
+TONEMAP_LINE(clip,     sig = av_clipf(sig * p->param, 0, 1.0f))
+TONEMAP_LINE(hable,    sig = hable(sig) / p->hable_peak)
+TONEMAP_LINE(reinhard, sig = sig / (sig + p->param) * (p->peak + p->param) / p->peak)
+TONEMAP_LINE(mobius,   sig = sig <= p->j ? sig : p->scale * (sig + p->a) / (sig + p->b))
+
 typedef struct ThreadData {
     AVFrame *in, *out;
-    const AVPixFmtDescriptor *desc;
-    double peak;
+    TonemapParams params;
 } ThreadData;
 
 static int tonemap_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
@@ -203,14 +211,36 @@ static int tonemap_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs
     ThreadData *td = arg;
     AVFrame *in = td->in;
     AVFrame *out = td->out;
-    const AVPixFmtDescriptor *desc = td->desc;
     const int slice_start = (in->height * jobnr) / nb_jobs;
     const int slice_end = (in->height * (jobnr+1)) / nb_jobs;
-    double peak = td->peak;
+    const int width = out->width;
+
+    for (int y = slice_start; y < slice_end; y++) {
+        const float *i0 = (const float *)(in->data[0] + y * in->linesize[0]);
+        const float *i1 = (const float *)(in->data[1] + y * in->linesize[1]);
+        const float *i2 = (const float *)(in->data[2] + y * in->linesize[2]);
+        float *c0 = (float *)(out->data[0] + y * out->linesize[0]);
+        float *c1 = (float *)(out->data[1] + y * out->linesize[1]);
+        float *c2 = (float *)(out->data[2] + y * out->linesize[2]);
+
+        if (s->desat > 0) {
+            desaturate_line(s, c0, c1, c2, i0, i1, i2, width);
+        } else {
+            memcpy(c0, i0, width * sizeof(*c0));
+            memcpy(c1, i1, width * sizeof(*c1));
+            memcpy(c2, i2, width * sizeof(*c2));
+        }
 
-    for (int y = slice_start; y < slice_end; y++)
-        for (int x = 0; x < out->width; x++)
-            tonemap(s, out, in, desc, x, y, peak);
+        switch (s->tonemap) {
+        case TONEMAP_LINEAR:   tonemap_line_linear  (&td->params, c0, c1, c2, width); break;
+        case TONEMAP_GAMMA:    tonemap_line_gamma   (&td->params, c0, c1, c2, width); break;
+        case TONEMAP_CLIP:     tonemap_line_clip    (&td->params, c0, c1, c2, width); break;
+        case TONEMAP_HABLE:    tonemap_line_hable   (&td->params, c0, c1, c2, width); break;
+        case TONEMAP_REINHARD: tonemap_line_reinhard(&td->params, c0, c1, c2, width); break;
+        case TONEMAP_MOBIUS:   tonemap_line_mobius  (&td->params, c0, c1, c2, width); break;
+        default:               break;
+        }
+    }
 
     return 0;
 }
@@ -273,8 +303,7 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
     /* do the tone map */
     td.out = out;
     td.in = in;
-    td.desc = desc;
-    td.peak = peak;
+    tonemap_params(s, &td.params, peak);
     ctx->internal->execute(ctx, tonemap_slice, &td, NULL, FFMIN(in->height, ff_filter_get_nb_threads(ctx)));
 
     /* copy/generate alpha if needed */
@@ -162,6 +162,7 @@ static const AVOption v360_options[] = {
     {    "iv_fov", "input vertical field of view",  OFFSET(iv_fov), AV_OPT_TYPE_FLOAT,  {.dbl=45.f},     0.00001f,               360.f,TFLAGS, "iv_fov"},
     {    "id_fov", "input diagonal field of view",  OFFSET(id_fov), AV_OPT_TYPE_FLOAT,  {.dbl=0.f},           0.f,               360.f,TFLAGS, "id_fov"},
     {"alpha_mask", "build mask in alpha plane",      OFFSET(alpha), AV_OPT_TYPE_BOOL,   {.i64=0},               0,                   1, FLAGS, "alpha"},
+    {      "lazy", "calculate remap data per frame",      OFFSET(lazy), AV_OPT_TYPE_BOOL,   {.i64=0},               0,                   1, FLAGS, "lazy"},
     { NULL }
 };
 
@@ -269,6 +270,12 @@ static void remap1_##bits##bit_line_c(uint8_t *dst, int width, const uint8_t *co
 DEFINE_REMAP1_LINE( 8, 1)
 DEFINE_REMAP1_LINE(16, 2)
 
+/* number of rows of remap data calculated at once in lazy mode */
+#define LAZY_ROWS 16
+
+static void calculate_rows(const V360Context *s, int p, int row_start, int row_end,
+                           int16_t *us, int16_t *vs, int16_t *kers, uint8_t *mask);
+
 /**
  * Generate remapping function with a given window size and pixel depth.
  *
@@ -276,17 +283,12 @@ DEFINE_REMAP1_LINE(16, 2)
  * @param bits number of bits per pixel
  */
 #define DEFINE_REMAP(ws, bits)                                                                             \
-static int remap##ws##_##bits##bit_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)          \
+static void remap##ws##_##bits##bit_rows(const V360Context *s, const SliceXYRemap *r,                      \
+                                         const AVFrame *in, AVFrame *out,                                  \
+                                         unsigned map, int table_start, int row_start, int row_end)        \
 {                                                                                                          \
-    ThreadData *td = arg;                                                                                  \
-    const V360Context *s = ctx->priv;                                                                      \
-    const SliceXYRemap *r = &s->slice_remap[jobnr];                                                        \
-    const AVFrame *in = td->in;                                                                            \
-    AVFrame *out = td->out;                                                                                \
-                                                                                                           \
     for (int stereo = 0; stereo < 1 + s->out_stereo > STEREO_2D; stereo++) {                               \
         for (int plane = 0; plane < s->nb_planes; plane++) {                                               \
-            const unsigned map = s->map[plane];                                                            \
             const int in_linesize  = in->linesize[plane];                                                  \
             const int out_linesize = out->linesize[plane];                                                 \
             const int uv_linesize = s->uv_linesize[plane];                                                 \
@@ -299,24 +301,50 @@ static int remap##ws##_##bits##bit_slice(AVFilterContext *ctx, void *arg, int jo
             uint8_t *dst = out->data[plane] + out_offset_h * out_linesize + out_offset_w * (bits >> 3);    \
             const uint8_t *mask = plane == 3 ? r->mask : NULL;                                             \
             const int width = s->pr_width[plane];                                                          \
-            const int height = s->pr_height[plane];                                                        \
                                                                                                            \
-            const int slice_start = (height *  jobnr     ) / nb_jobs;                                      \
-            const int slice_end   = (height * (jobnr + 1)) / nb_jobs;                                      \
+            if (s->map[plane] != map)                                                                      \
+                continue;                                                                                  \
                                                                                                            \
-            for (int y = slice_start; y < slice_end && !mask; y++) {                                       \
-                const int16_t *const u = r->u[map] + (y - slice_start) * uv_linesize * ws * ws;            \
-                const int16_t *const v = r->v[map] + (y - slice_start) * uv_linesize * ws * ws;            \
-                const int16_t *const ker = r->ker[map] + (y - slice_start) * uv_linesize * ws * ws;        \
+            for (int y = row_start; y < row_end && !mask; y++) {                                           \
+                const int16_t *const u = r->u[map] + (y - table_start) * uv_linesize * ws * ws;            \
+                const int16_t *const v = r->v[map] + (y - table_start) * uv_linesize * ws * ws;            \
+                const int16_t *const ker = r->ker[map] + (y - table_start) * uv_linesize * ws * ws;        \
                                                                                                            \
                 s->remap_line(dst + y * out_linesize, width, src, in_linesize, u, v, ker);                 \
             }                                                                                              \
                                                                                                            \
-            for (int y = slice_start; y < slice_end && mask; y++) {                                        \
+            for (int y = row_start; y < row_end && mask; y++) {                                            \
                 memcpy(dst + y * out_linesize, mask +                                                      \
-                       (y - slice_start) * width * (bits >> 3), width * (bits >> 3));                      \
+                       (y - table_start) * width * (bits >> 3), width * (bits >> 3));                      \
             }                                                                                              \
         }                                                                                                  \
+    }                                                                                                      \
+}                                                                                                          \
+                                                                                                           \
+static int remap##ws##_##bits##bit_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)          \
+{                                                                                                          \
+    ThreadData *td = arg;                                                                                  \
+    const V360Context *s = ctx->priv;                                                                      \
+    const SliceXYRemap *r = &s->slice_remap[jobnr];                                                        \
+    const AVFrame *in = td->in;                                                                            \
+    AVFrame *out = td->out;                                                                                \
+                                                                                                           \
+    for (int map = 0; map < s->nb_allocated; map++) {                                                      \
+        const int height = s->pr_height[map];                                                               \
+        const int slice_start = (height *  jobnr     ) / nb_jobs;                                          \
+        const int slice_end   = (height * (jobnr + 1)) / nb_jobs;                                          \
+                                                                                                           \
+        if (!s->lazy) {                                                                                    \
+            remap##ws##_##bits##bit_rows(s, r, in, out, map, slice_start, slice_start, slice_end);         \
+            continue;                                                                                      \
+        }                                                                                                  \
+                                                                                                           \
+        for (int y = slice_start; y < slice_end; y += LAZY_ROWS) {                                         \
+            const int y_end = FFMIN(y + LAZY_ROWS, slice_end);                                             \
+                                                                                                           \
+            calculate_rows(s, map, y, y_end, r->u[map], r->v[map], r->ker[map], map ? NULL : r->mask);     \
+            remap##ws##_##bits##bit_rows(s, r, in, out, map, y, y, y_end);                                 \
+        }                                                                                                  \
     }                                                                                                      \
                                                                                                            \
     return 0;                                                                                              \
@@ -3974,7 +4002,7 @@ static int allocate_plane(V360Context *s, int sizeof_uv, int sizeof_ker, int siz
         SliceXYRemap *r = &s->slice_remap[n];
         const int slice_start = (pr_height *  n     ) / s->nb_threads;
         const int slice_end   = (pr_height * (n + 1)) / s->nb_threads;
-        const int height = slice_end - slice_start;
+        const int height = s->lazy ? FFMIN(slice_end - slice_start, LAZY_ROWS) : slice_end - slice_start;
 
         if (!r->u[p])
             r->u[p] = av_calloc(s->uv_linesize[p] * height, sizeof_uv);
@@ -4077,61 +4105,82 @@ static void set_dimensions(int *outw, int *outh, int w, int h, const AVPixFmtDes
     outh[0] = outh[3] = h;
 }
 
+/**
+ * Calculate remap data for a range of rows of one plane.
+ *
+ * @param s filter private context
+ * @param p index of the allocated remap plane
+ * @param row_start first row to calculate
+ * @param row_end row after the last one to calculate
+ * @param us u remap data, starting at row_start
+ * @param vs v remap data, starting at row_start
+ * @param kers ker remap data, starting at row_start
+ * @param mask alpha mask, starting at row_start, or NULL
+ */
+static void calculate_rows(const V360Context *s, int p, int row_start, int row_end,
+                           int16_t *us, int16_t *vs, int16_t *kers, uint8_t *mask)
+{
+    const int max_value = s->max_value;
+    const int width = s->pr_width[p];
+    const int uv_linesize = s->uv_linesize[p];
+    const int height = s->pr_height[p];
+    const int in_width = s->inplanewidth[p];
+    const int in_height = s->inplaneheight[p];
+    const int elements = s->elements;
+    float du, dv;
+    float vec[3];
+    XYRemap rmap;
+
+    for (int j = row_start; j < row_end; j++) {
+        for (int i = 0; i < width; i++) {
+            int16_t *u = us + ((j - row_start) * uv_linesize + i) * elements;
+            int16_t *v = vs + ((j - row_start) * uv_linesize + i) * elements;
+            int16_t *ker = kers + ((j - row_start) * uv_linesize + i) * elements;
+            uint8_t *mask8 = mask ? mask + ((j - row_start) * s->pr_width[0] + i) : NULL;
+            uint16_t *mask16 = mask ? (uint16_t *)mask + ((j - row_start) * s->pr_width[0] + i) : NULL;
+            int in_mask, out_mask;
+
+            if (s->out_transpose)
+                out_mask = s->out_transform(s, j, i, height, width, vec);
+            else
+                out_mask = s->out_transform(s, i, j, width, height, vec);
+            av_assert1(!isnan(vec[0]) && !isnan(vec[1]) && !isnan(vec[2]));
+            rotate(s->rot_quaternion, vec);
+            av_assert1(!isnan(vec[0]) && !isnan(vec[1]) && !isnan(vec[2]));
+            normalize_vector(vec);
+            mirror(s->output_mirror_modifier, vec);
+            if (s->in_transpose)
+                in_mask = s->in_transform(s, vec, in_height, in_width, rmap.v, rmap.u, &du, &dv);
+            else
+                in_mask = s->in_transform(s, vec, in_width, in_height, rmap.u, rmap.v, &du, &dv);
+            input_flip(rmap.u, rmap.v, in_width, in_height, s->ih_flip, s->iv_flip);
+            av_assert1(!isnan(du) && !isnan(dv));
+            s->calculate_kernel(du, dv, &rmap, u, v, ker);
+
+            if (mask) {
+                if (s->mask_size == 1) {
+                    mask8[0] = 255 * (out_mask & in_mask);
+                } else {
+                    mask16[0] = max_value * (out_mask & in_mask);
+                }
+            }
+        }
+    }
+}
+
 // Calculate remap data
-static av_always_inline int v360_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+static int v360_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
     V360Context *s = ctx->priv;
     SliceXYRemap *r = &s->slice_remap[jobnr];
 
     for (int p = 0; p < s->nb_allocated; p++) {
-        const int max_value = s->max_value;
-        const int width = s->pr_width[p];
-        const int uv_linesize = s->uv_linesize[p];
         const int height = s->pr_height[p];
-        const int in_width = s->inplanewidth[p];
-        const int in_height = s->inplaneheight[p];
         const int slice_start = (height *  jobnr     ) / nb_jobs;
         const int slice_end   = (height * (jobnr + 1)) / nb_jobs;
-        const int elements = s->elements;
-        float du, dv;
-        float vec[3];
-        XYRemap rmap;
-
-        for (int j = slice_start; j < slice_end; j++) {
-            for (int i = 0; i < width; i++) {
-                int16_t *u = r->u[p] + ((j - slice_start) * uv_linesize + i) * elements;
-                int16_t *v = r->v[p] + ((j - slice_start) * uv_linesize + i) * elements;
-                int16_t *ker = r->ker[p] + ((j - slice_start) * uv_linesize + i) * elements;
-                uint8_t *mask8 = p ? NULL : r->mask + ((j - slice_start) * s->pr_width[0] + i);
-                uint16_t *mask16 = p ? NULL : (uint16_t *)r->mask + ((j - slice_start) * s->pr_width[0] + i);
-                int in_mask, out_mask;
-
-                if (s->out_transpose)
-                    out_mask = s->out_transform(s, j, i, height, width, vec);
-                else
-                    out_mask = s->out_transform(s, i, j, width, height, vec);
-                av_assert1(!isnan(vec[0]) && !isnan(vec[1]) && !isnan(vec[2]));
-                rotate(s->rot_quaternion, vec);
-                av_assert1(!isnan(vec[0]) && !isnan(vec[1]) && !isnan(vec[2]));
-                normalize_vector(vec);
-                mirror(s->output_mirror_modifier, vec);
-                if (s->in_transpose)
-                    in_mask = s->in_transform(s, vec, in_height, in_width, rmap.v, rmap.u, &du, &dv);
-                else
-                    in_mask = s->in_transform(s, vec, in_width, in_height, rmap.u, rmap.v, &du, &dv);
-                input_flip(rmap.u, rmap.v, in_width, in_height, s->ih_flip, s->iv_flip);
-                av_assert1(!isnan(du) && !isnan(dv));
-                s->calculate_kernel(du, dv, &rmap, u, v, ker);
-
-                if (!p && r->mask) {
-                    if (s->mask_size == 1) {
-                        mask8[0] = 255 * (out_mask & in_mask);
-                    } else {
-                        mask16[0] = max_value * (out_mask & in_mask);
-                    }
-                }
-            }
-        }
+
+        calculate_rows(s, p, slice_start, slice_end,
+                       r->u[p], r->v[p], r->ker[p], p ? NULL : r->mask);
     }
 
     return 0;
@@ -4674,7 +4723,8 @@ static int config_output(AVFilterLink *outlink)
 
     set_mirror_modifier(s->h_flip, s->v_flip, s->d_flip, s->output_mirror_modifier);
 
-    ctx->internal->execute(ctx, v360_slice, NULL, NULL, s->nb_threads);
+    if (!s->lazy)
+        ctx->internal->execute(ctx, v360_slice, NULL, NULL, s->nb_threads);
 
     return 0;
 }
@@ -315,6 +315,92 @@ static void check_idct_multiple(void)
 }
 
 
+static void check_weight(void)
+{
+    LOCAL_ALIGNED_16(uint8_t, dst, [16 * 16 * 2]);
+    LOCAL_ALIGNED_16(uint8_t, dst0, [16 * 16 * 2]);
+    LOCAL_ALIGNED_16(uint8_t, dst1, [16 * 16 * 2]);
+    H264DSPContext h;
+    int bit_depth, i, j;
+
+    declare_func_emms(AV_CPU_FLAG_MMX, void, uint8_t *block, ptrdiff_t stride,
+                      int height, int log2_denom, int weight, int offset);
+
+    for (bit_depth = 8; bit_depth <= 10; bit_depth++) {
+        uint32_t mask = pixel_mask[bit_depth - 8];
+        ff_h264dsp_init(&h, bit_depth, 1);
+        for (i = 0; i < 3; i++) {
+            int w = 16 >> i;
+            if (check_func(h.weight_h264_pixels_tab[i], "h264_weight%d_%dbpp", w, bit_depth)) {
+                for (j = 0; j < 16; j++) {
+                    int log2_denom = rnd() % 8;
+                    int weight     = rnd() % 129 - 64;
+                    int offset     = rnd() % 256 - 128;
+                    int k;
+                    for (k = 0; k < 16 * 16 * 2; k += 4)
+                        AV_WN32A(dst + k, rnd() & mask);
+                    memcpy(dst0, dst, 16 * 16 * 2);
+                    memcpy(dst1, dst, 16 * 16 * 2);
+                    call_ref(dst0, 32, w, log2_denom, weight, offset);
+                    call_new(dst1, 32, w, log2_denom, weight, offset);
+                    if (memcmp(dst0, dst1, 16 * 16 * 2)) {
+                        fprintf(stderr, "h264_weight%d: log2_denom:%d weight:%d "
+                                "offset:%d\n", w, log2_denom, weight, offset);
+                        fail();
+                    }
+                    bench_new(dst1, 32, w, log2_denom, weight, offset);
+                }
+            }
+        }
+    }
+}
+
+static void check_biweight(void)
+{
+    LOCAL_ALIGNED_16(uint8_t, src, [16 * 16 * 2]);
+    LOCAL_ALIGNED_16(uint8_t, dst, [16 * 16 * 2]);
+    LOCAL_ALIGNED_16(uint8_t, dst0, [16 * 16 * 2]);
+    LOCAL_ALIGNED_16(uint8_t, dst1, [16 * 16 * 2]);
+    H264DSPContext h;
+    int bit_depth, i, j;
+
+    declare_func_emms(AV_CPU_FLAG_MMX, void, uint8_t *dst, uint8_t *src,
+                      ptrdiff_t stride, int height, int log2_denom,
+                      int weightd, int weights, int offset);
+
+    for (bit_depth = 8; bit_depth <= 10; bit_depth++) {
+        uint32_t mask = pixel_mask[bit_depth - 8];
+        ff_h264dsp_init(&h, bit_depth, 1);
+        for (i = 0; i < 3; i++) {
+            int w = 16 >> i;
+            if (check_func(h.biweight_h264_pixels_tab[i], "h264_biweight%d_%dbpp", w, bit_depth)) {
+                for (j = 0; j < 16; j++) {
+                    int log2_denom = rnd() % 8;
+                    int weightd    = rnd() % 129 - 64;
+                    int weights    = rnd() % 129 - 64;
+                    int offset     = rnd() % 256 - 128;
+                    int k;
+                    for (k = 0; k < 16 * 16 * 2; k += 4) {
+                        AV_WN32A(src + k, rnd() & mask);
+                        AV_WN32A(dst + k, rnd() & mask);
+                    }
+                    memcpy(dst0, dst, 16 * 16 * 2);
+                    memcpy(dst1, dst, 16 * 16 * 2);
+                    call_ref(dst0, src, 32, w, log2_denom, weightd, weights, offset);
+                    call_new(dst1, src, 32, w, log2_denom, weightd, weights, offset);
+                    if (memcmp(dst0, dst1, 16 * 16 * 2)) {
+                        fprintf(stderr, "h264_biweight%d: log2_denom:%d weightd:%d "
+                                "weights:%d offset:%d\n", w, log2_denom,
+                                weightd, weights, offset);
+                        fail();
+                    }
+                    bench_new(dst1, src, 32, w, log2_denom, weightd, weights, offset);
+                }
+            }
+        }
+    }
+}
+
 static void check_loop_filter(void)
 {
     LOCAL_ALIGNED_16(uint8_t, dst, [32 * 16 * 2]);
@@ -445,6 +531,10 @@ void checkasm_check_h264dsp(void)
     check_idct_multiple();
     report("idct");
 
+    check_weight();
+    check_biweight();
+    report("weight");
+
     check_loop_filter();
     report("loop_filter");
 
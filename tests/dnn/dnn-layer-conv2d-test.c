@@ -98,6 +98,7 @@ static int test_with_same_dilate(void)
 
     NativeContext ctx;
     ctx.class = NULL;
+    ctx.nb_threads = 1;
     ctx.options.conv2d_threads = 1;
 
     params.activation = TANH;
@@ -118,7 +119,11 @@ static int test_with_same_dilate(void)
     operands[1].data = NULL;
 
     input_indexes[0] = 0;
+    if (ff_dnn_init_layer_conv2d(&params) < 0)
+        return 1;
     ff_dnn_execute_layer_conv2d(operands, input_indexes, 1, &params, &ctx);
+    av_freep(&params.packed_kernel);
+    av_freep(&params.fdsp);
 
     output = operands[1].data;
     for (int i = 0; i < sizeof(expected_output) / sizeof(float); i++) {
@@ -202,6 +207,7 @@ static int test_with_valid(void)
 
     NativeContext ctx;
     ctx.class = NULL;
+    ctx.nb_threads = 1;
     ctx.options.conv2d_threads = 1;
 
     params.activation = TANH;
@@ -222,7 +228,11 @@ static int test_with_valid(void)
     operands[1].data = NULL;
 
     input_indexes[0] = 0;
+    if (ff_dnn_init_layer_conv2d(&params) < 0)
+        return 1;
     ff_dnn_execute_layer_conv2d(operands, input_indexes, 1, &params, &ctx);
+    av_freep(&params.packed_kernel);
+    av_freep(&params.fdsp);
 
     output = operands[1].data;
     for (int i = 0; i < sizeof(expected_output) / sizeof(float); i++) {
@@ -237,12 +247,114 @@ static int test_with_valid(void)
     return 0;
 }
 
+static int test_with_reference(DNNPaddingParam padding, int dilation)
+{
+    // compare against a direct computation on an input wider than
+    // the tile of patches which are gathered at once
+#define REF_HEIGHT 6
+#define REF_WIDTH 37
+#define REF_IN 5
+#define REF_OUT 7
+#define REF_KSIZE 3
+    ConvolutionalParams params;
+    DnnOperand operands[2];
+    int32_t input_indexes[1];
+    NativeContext ctx;
+    float input[REF_HEIGHT * REF_WIDTH * REF_IN];
+    float kernel[REF_OUT * REF_KSIZE * REF_KSIZE * REF_IN];
+    float bias[REF_OUT];
+    float *output;
+    int ret;
+    int radius = REF_KSIZE >> 1;
+    int pad = padding == VALID ? radius * dilation : 0;
+    int out_w = REF_WIDTH - 2 * pad;
+
+    for (int i = 0; i < FF_ARRAY_ELEMS(input); i++)
+        input[i] = ((i * 7919) % 1000) / 1000.0f - 0.5f;
+    for (int i = 0; i < FF_ARRAY_ELEMS(kernel); i++)
+        kernel[i] = ((i * 104729) % 997) / 997.0f - 0.5f;
+    for (int i = 0; i < REF_OUT; i++)
+        bias[i] = i * 0.1f - 0.3f;
+
+    ctx.class = NULL;
+    ctx.nb_threads = 1;
+    ctx.options.conv2d_threads = 2;
+
+    params.activation = NONE;
+    params.has_bias = 1;
+    params.biases = bias;
+    params.dilation = dilation;
+    params.input_num = REF_IN;
+    params.kernel = kernel;
+    params.kernel_size = REF_KSIZE;
+    params.output_num = REF_OUT;
+    params.padding_method = padding;
+
+    operands[0].data = input;
+    operands[0].dims[0] = 1;
+    operands[0].dims[1] = REF_HEIGHT;
+    operands[0].dims[2] = REF_WIDTH;
+    operands[0].dims[3] = REF_IN;
+    operands[1].data = NULL;
+
+    input_indexes[0] = 0;
+    if (ff_dnn_init_layer_conv2d(&params) < 0)
+        return 1;
+    ret = ff_dnn_execute_layer_conv2d(operands, input_indexes, 1, &params, &ctx);
+    av_freep(&params.packed_kernel);
+    av_freep(&params.fdsp);
+    if (ret) {
+        printf("conv2d layer failed\n");
+        return 1;
+    }
+
+    output = operands[1].data;
+    for (int y = pad; y < REF_HEIGHT - pad; y++) {
+        for (int x = pad; x < REF_WIDTH - pad; x++) {
+            for (int n = 0; n < REF_OUT; n++) {
+                float expected = bias[n];
+                int idx = ((y - pad) * out_w + x - pad) * REF_OUT + n;
+                for (int ky = 0; ky < REF_KSIZE; ky++) {
+                    for (int kx = 0; kx < REF_KSIZE; kx++) {
+                        int y_pos = y + (ky - radius) * dilation;
+                        int x_pos = x + (kx - radius) * dilation;
+                        if (padding == SAME_CLAMP_TO_EDGE) {
+                            y_pos = av_clip(y_pos, 0, REF_HEIGHT - 1);
+                            x_pos = av_clip(x_pos, 0, REF_WIDTH - 1);
+                        } else if (x_pos < 0 || x_pos >= REF_WIDTH || y_pos < 0 || y_pos >= REF_HEIGHT) {
+                            continue;
+                        }
+                        for (int ch = 0; ch < REF_IN; ch++)
+                            expected += input[(y_pos * REF_WIDTH + x_pos) * REF_IN + ch] *
+                                        kernel[((n * REF_KSIZE + ky) * REF_KSIZE + kx) * REF_IN + ch];
+                    }
+                }
+                if (fabs(output[idx] - expected) > EPSON) {
+                    printf("padding %d dilation %d at index %d, output: %f, expected_output: %f\n",
+                           padding, dilation, idx, output[idx], expected);
+                    av_freep(&output);
+                    return 1;
+                }
+            }
+        }
+    }
+
+    av_freep(&output);
+    return 0;
+}
+
 int main(int argc, char **argv)
 {
     if (test_with_valid())
         return 1;
     if (test_with_same_dilate())
         return 1;
+    if (test_with_reference(VALID, 1))
+        return 1;
+    if (test_with_reference(SAME, 2))
+        return 1;
+    if (test_with_reference(SAME_CLAMP_TO_EDGE, 1))
+        return 1;
 
     return 0;
 }
@@ -107,7 +107,11 @@ static int test(void)
     operands[1].data = NULL;
 
     input_indexes[0] = 0;
+    if (ff_dnn_init_layer_dense(&params) < 0)
+        return 1;
     ff_dnn_execute_layer_dense(operands, input_indexes, 1, &params, NULL);
+    av_freep(&params.packed_kernel);
+    av_freep(&params.fdsp);
 
     output = operands[1].data;
     for (int i = 0; i < sizeof(expected_output) / sizeof(float); i++) {
@@ -106,6 +106,15 @@ probeframes(){
     run ffprobe${PROGSUF}${EXECSUF} -show_frames "$@"
 }
 
+# Check that the frame properties and side data exported with skip_recon all
+# match the ones of a full decode.
+probeframes_skip_recon(){
+    reconfile="${outdir}/${test}.recon"
+    cleanfiles="$cleanfiles $reconfile"
+    probeframes -skip_recon none "$@" >$reconfile || return
+    probeframes -skip_recon all "$@" | diff -u $reconfile -
+}
+
 probechapters(){
     run ffprobe${PROGSUF}${EXECSUF} -show_chapters "$@"
 }
@@ -147,6 +156,20 @@ framemd5(){
     ffmpeg "$@" -bitexact -f framemd5 -
 }
 
+# Check that decoding with the configured threads gives the same frames as
+# decoding with a single thread.
+framecrc_threads(){
+    threadfile="${outdir}/${test}.threads1"
+    cleanfiles="$cleanfiles $threadfile"
+    nb_threads=$threads
+    threads=1
+    framecrc "$@" >$threadfile
+    ret=$?
+    threads=$nb_threads
+    test $ret = 0 || return $ret
+    framecrc "$@" | diff -u $threadfile -
+}
+
 crc(){
     ffmpeg "$@" -f crc -
 }
@@ -29,6 +29,12 @@ FATE_FFPROBE-$(CONFIG_AVDEVICE) += fate-ffprobe_xml
 fate-ffprobe_xml: $(FFPROBE_TEST_FILE)
 fate-ffprobe_xml: CMD = run $(FFPROBE_COMMAND) -of xml
 
+# frame properties and side data exported with skip_recon must match the decoded ones
+FATE_FFPROBE-$(call ENCDEC, MPEG4, AVI) += fate-ffprobe-skip-recon-all fate-ffprobe-skip-recon-none
+fate-ffprobe-skip-recon-%: fate-vsynth1-mpeg4-qprd
+fate-ffprobe-skip-recon-%: REF = $(SRC_PATH)/tests/ref/fate/ffprobe-skip-recon
+fate-ffprobe-skip-recon-%: CMD = probeframes -export_side_data mvs+venc_params -skip_recon $(@:fate-ffprobe-skip-recon-%=%) -show_entries frame=key_frame,pkt_dts,pkt_size,pict_type,coded_picture_number,display_picture_number,side_data_list $(TARGET_PATH)/tests/data/fate/vsynth1-mpeg4-qprd.avi
+
 FATE_FFPROBE += $(FATE_FFPROBE-yes)
 
 fate-ffprobe: $(FATE_FFPROBE)
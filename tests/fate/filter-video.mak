@@ -586,6 +586,12 @@ FATE_FILTER_VSYNTH-$(CONFIG_CODECVIEW_FILTER) += fate-filter-codecview
 fate-filter-codecview: fate-vsynth1-mpeg4-qprd
 fate-filter-codecview: CMD = framecrc -flags bitexact -idct simple -flags2 +export_mvs -i $(TARGET_PATH)/tests/data/fate/vsynth1-mpeg4-qprd.avi -frames:v 5 -flags +bitexact -vf codecview=mv=pf+bf+bb
 
+# the motion vectors exported with skip_recon must match the decoded ones
+FATE_FILTER_VSYNTH-$(call ALLYES, CODECVIEW_FILTER DRAWBOX_FILTER) += fate-filter-codecview-skip-recon-all fate-filter-codecview-skip-recon-none
+fate-filter-codecview-skip-recon-%: fate-vsynth1-mpeg4-qprd
+fate-filter-codecview-skip-recon-%: REF = $(SRC_PATH)/tests/ref/fate/filter-codecview-skip-recon
+fate-filter-codecview-skip-recon-%: CMD = framecrc -flags bitexact -idct simple -flags2 +export_mvs -skip_recon $(@:fate-filter-codecview-skip-recon-%=%) -i $(TARGET_PATH)/tests/data/fate/vsynth1-mpeg4-qprd.avi -frames:v 10 -flags +bitexact -vf drawbox=t=fill:c=black,codecview=mv=pf+bf+bb
+
 FATE_FILTER_VSYNTH-$(call ALLYES, QP_FILTER PP_FILTER) += fate-filter-qp
 fate-filter-qp: CMD = video_filter "qp=34,pp=be/hb/vb/tn/l5/al"
 
@@ -859,6 +865,9 @@ fate-filter-refcmp-ssim-rgb: CMD = refcmp_metadata ssim rgb24 0.015
 FATE_FILTER_SAMPLES-$(call ALLYES, $(REFCMP_DEPS) SSIM_FILTER) += fate-filter-refcmp-ssim-yuv
 fate-filter-refcmp-ssim-yuv: CMD = refcmp_metadata ssim yuv422p 0.015
 
+FATE_FILTER_SAMPLES-$(call ALLYES, $(REFCMP_DEPS) QUALITYMETRICS_FILTER) += fate-filter-refcmp-qualitymetrics-yuv
+fate-filter-refcmp-qualitymetrics-yuv: CMD = refcmp_metadata qualitymetrics yuv422p 0.015
+
 FATE_SAMPLES_FFPROBE += $(FATE_METADATA_FILTER-yes)
 FATE_SAMPLES_FFMPEG += $(FATE_FILTER_SAMPLES-yes)
 FATE_FFMPEG += $(FATE_FILTER-yes)
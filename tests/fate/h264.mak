@@ -229,6 +229,26 @@ FATE_H264-$(call DEMDEC, MOV, H264) += fate-h264-attachment-631
 FATE_H264-$(call DEMDEC, MPEGTS, H264) += fate-h264-skip-nokey fate-h264-skip-nointra
 FATE_H264_FFPROBE-$(call DEMDEC, MATROSKA, H264) += fate-h264-dts_5frames
 
+# frame properties and side data exported with skip_recon must match the decoded ones
+FATE_H264_FFPROBE-$(call DEMDEC, H264, H264) += fate-h264-skip-recon
+fate-h264-skip-recon: CMD = probeframes_skip_recon -export_side_data mvs+venc_params -show_entries frame=key_frame,pkt_dts,pkt_size,pict_type,coded_picture_number,display_picture_number,side_data_list $(TARGET_SAMPLES)/h264-conformance/CABA3_TOSHIBA_E.264
+fate-h264-skip-recon: CMP = null
+
+# lowres output only approximates the full resolution picture; check that it
+# does not depend on frame or slice threading, the latter on a sample with
+# several slices per picture
+H264_LOWRES_SAMPLE_frame = CABA3_SVA_B.264
+H264_LOWRES_SAMPLE_slice = BA1_FT_C.264
+
+define FATE_H264_LOWRES_TEST
+FATE_H264_LOWRES += fate-h264-lowres$(1)-$(2)
+fate-h264-lowres$(1)-$(2): CMD = threads=4 thread_type=$(2) framecrc_threads -lowres $(1) -i $(TARGET_SAMPLES)/h264-conformance/$(H264_LOWRES_SAMPLE_$(2))
+fate-h264-lowres$(1)-$(2): CMP = null
+endef
+
+$(foreach L,1 2 3,$(foreach T,frame slice,$(eval $(call FATE_H264_LOWRES_TEST,$(L),$(T)))))
+FATE_H264-$(call DEMDEC, H264, H264) += $(FATE_H264_LOWRES)
+
 FATE_SAMPLES_AVCONV += $(FATE_H264-yes)
 FATE_SAMPLES_FFPROBE += $(FATE_H264_FFPROBE-yes)
 fate-h264: $(FATE_H264-yes) $(FATE_H264_FFPROBE-yes)
@@ -282,6 +282,27 @@ FATE_HEVC-$(call DEMDEC, HEVC, HEVC) += fate-hevc-cabac-tudepth
 fate-hevc-small422chroma: CMD = framecrc -flags unaligned -i $(TARGET_SAMPLES)/hevc/food.hevc -pix_fmt yuv422p10le -vf scale
 FATE_HEVC-$(call DEMDEC, HEVC, HEVC) += fate-hevc-small422chroma
 
+# skip_recon must not change the exported frame properties, and the SEI MD5
+# check must not reject the frames that were only parsed
+FATE_HEVC_FFPROBE-$(call DEMDEC, HEVC, HEVC) += fate-hevc-skip-recon
+fate-hevc-skip-recon: CMD = probeframes_skip_recon -err_detect crccheck+explode -show_entries frame=key_frame,pkt_dts,pkt_size,pict_type,coded_picture_number,display_picture_number,side_data_list $(TARGET_SAMPLES)/hevc-conformance/RPS_A_docomo_4.bit
+fate-hevc-skip-recon: CMP = null
+
+# lowres pictures are downscaled from the full resolution ones, which are
+# verified against the SEI checksums; check that the output does not depend
+# on frame or slice threading, the latter on a sample using WPP
+HEVC_LOWRES_SAMPLE_frame = RPS_A_docomo_4.bit
+HEVC_LOWRES_SAMPLE_slice = WPP_A_ericsson_MAIN_2.bit
+
+define FATE_HEVC_LOWRES_TEST
+FATE_HEVC_LOWRES += fate-hevc-lowres$(1)-$(2)
+fate-hevc-lowres$(1)-$(2): CMD = threads=4 thread_type=$(2) framecrc_threads -flags unaligned -err_detect crccheck+explode -lowres $(1) -i $(TARGET_SAMPLES)/hevc-conformance/$(HEVC_LOWRES_SAMPLE_$(2))
+fate-hevc-lowres$(1)-$(2): CMP = null
+endef
+
+$(foreach L,1 2 3,$(foreach T,frame slice,$(eval $(call FATE_HEVC_LOWRES_TEST,$(L),$(T)))))
+FATE_HEVC-$(call DEMDEC, HEVC, HEVC) += $(FATE_HEVC_LOWRES)
+
 FATE_SAMPLES_AVCONV += $(FATE_HEVC-yes)
 FATE_SAMPLES_FFPROBE += $(FATE_HEVC_FFPROBE-yes)
 